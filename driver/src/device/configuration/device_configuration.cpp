@@ -19,8 +19,11 @@ const char* k_pose_settings_section = "pose_settings";
 
 const char* k_serial_communication_settings_section = "communication_serial";
 const char* k_btserial_communication_settings_section = "communication_btserial";
+const char* k_udp_communication_settings_section = "communication_udp";
 const char* k_namedpipe_communication_settings_section = "communication_namedpipe";
+const char* k_sharedmemory_communication_settings_section = "communication_sharedmemory";
 const char* k_alpha_encoding_settings_section = "encoding_alpha";
+const char* k_binary_encoding_settings_section = "encoding_binary";
 
 nlohmann::ordered_map<std::string, std::variant<bool>> GetDriverConfigurationMap() {
   nlohmann::ordered_map<std::string, std::variant<bool>> result{};
@@ -47,23 +50,60 @@ nlohmann::ordered_map<std::string, std::variant<bool, std::string>> GetBluetooth
   return result;
 }
 
-nlohmann::ordered_map<std::string, std::variant<bool, std::string>> GetSerialConfigurationMap() {
+nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> GetSerialConfigurationMap() {
   vr::CVRSettingHelper settings_helper(vr::VRSettings());
 
-  nlohmann::ordered_map<std::string, std::variant<bool, std::string>> result{};
+  nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> result{};
 
   result["enabled"] = vr::VRSettings()->GetBool(k_serial_communication_settings_section, "enabled");
 
   result["left_port"] = settings_helper.GetString(k_serial_communication_settings_section, "left_port");
   result["right_port"] = settings_helper.GetString(k_serial_communication_settings_section, "right_port");
 
+  // 0 detects the rate the glove is sending at
+  result["baud_rate"] = vr::VRSettings()->GetInt32(k_serial_communication_settings_section, "baud_rate");
+  if (std::get<int>(result["baud_rate"]) < 0) {
+    DriverLog("baud_rate is negative. Detecting the rate the glove is sending at instead.");
+    result["baud_rate"] = 0;
+  }
+
   return result;
 }
 
-nlohmann::ordered_map<std::string, std::variant<bool>> GetNamedPipeConfigurationMap() {
-  nlohmann::ordered_map<std::string, std::variant<bool>> result{};
+nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> GetUdpConfigurationMap() {
+  vr::CVRSettingHelper settings_helper(vr::VRSettings());
+
+  nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> result{};
+
+  result["enabled"] = vr::VRSettings()->GetBool(k_udp_communication_settings_section, "enabled");
+
+  result["left_name"] = settings_helper.GetString(k_udp_communication_settings_section, "left_name");
+  result["right_name"] = settings_helper.GetString(k_udp_communication_settings_section, "right_name");
+
+  // gloves are found by their announcements unless an address is set
+  result["left_address"] = settings_helper.GetString(k_udp_communication_settings_section, "left_address");
+  result["right_address"] = settings_helper.GetString(k_udp_communication_settings_section, "right_address");
+  result["port"] = vr::VRSettings()->GetInt32(k_udp_communication_settings_section, "port");
+
+  return result;
+}
+
+nlohmann::ordered_map<std::string, std::variant<bool, std::string>> GetNamedPipeConfigurationMap() {
+  vr::CVRSettingHelper settings_helper(vr::VRSettings());
+
+  nlohmann::ordered_map<std::string, std::variant<bool, std::string>> result{};
   result["enabled"] = vr::VRSettings()->GetBool(k_namedpipe_communication_settings_section, "enabled");
 
+  // which client is forwarded when several write to a hand at once: "last_writer", "priority" or "freshest"
+  result["arbitration"] = settings_helper.GetString(k_namedpipe_communication_settings_section, "arbitration");
+
+  return result;
+}
+
+nlohmann::ordered_map<std::string, std::variant<bool>> GetSharedMemoryConfigurationMap() {
+  nlohmann::ordered_map<std::string, std::variant<bool>> result{};
+  result["enabled"] = vr::VRSettings()->GetBool(k_sharedmemory_communication_settings_section, "enabled");
+
   return result;
 }
 
@@ -79,6 +119,16 @@ nlohmann::ordered_map<std::string, std::variant<int>> GetAlphaEncodingConfigurat
   return result;
 }
 
+nlohmann::ordered_map<std::string, std::variant<bool>> GetBinaryEncodingConfigurationMap() {
+  nlohmann::ordered_map<std::string, std::variant<bool>> result{};
+
+  // gloves use the alpha encoding unless their firmware is set up to send binary frames
+  result["left_enabled"] = vr::VRSettings()->GetBool(k_binary_encoding_settings_section, "left_enabled");
+  result["right_enabled"] = vr::VRSettings()->GetBool(k_binary_encoding_settings_section, "right_enabled");
+
+  return result;
+}
+
 nlohmann::ordered_map<std::string, std::variant<float, bool>> GetPoseConfigurationMap() {
   nlohmann::ordered_map<std::string, std::variant<float, bool>> result{};
 
@@ -17,8 +17,11 @@ extern const char* k_pose_settings_section;
 
 extern const char* k_serial_communication_settings_section;
 extern const char* k_btserial_communication_settings_section;
+extern const char* k_udp_communication_settings_section;
 extern const char* k_namedpipe_communication_settings_section;
+extern const char* k_sharedmemory_communication_settings_section;
 extern const char* k_alpha_encoding_settings_section;
+extern const char* k_binary_encoding_settings_section;
 
 struct PoseConfiguration {
   vr::HmdQuaternion_t offset_orientation;
@@ -27,10 +30,13 @@ struct PoseConfiguration {
 
 nlohmann::ordered_map<std::string, std::variant<bool>> GetDriverConfigurationMap();
 nlohmann::ordered_map<std::string, std::variant<bool, std::string>> GetBluetoothSerialConfigurationMap();
-nlohmann::ordered_map<std::string, std::variant<bool, std::string>> GetSerialConfigurationMap();
-nlohmann::ordered_map<std::string, std::variant<bool>> GetNamedPipeConfigurationMap();
+nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> GetSerialConfigurationMap();
+nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> GetUdpConfigurationMap();
+nlohmann::ordered_map<std::string, std::variant<bool, std::string>> GetNamedPipeConfigurationMap();
+nlohmann::ordered_map<std::string, std::variant<bool>> GetSharedMemoryConfigurationMap();
 
 nlohmann::ordered_map<std::string, std::variant<int>> GetAlphaEncodingConfigurationMap();
+nlohmann::ordered_map<std::string, std::variant<bool>> GetBinaryEncodingConfigurationMap();
 nlohmann::ordered_map<std::string, std::variant<float, bool>> GetPoseConfigurationMap();
 
 PoseConfiguration GetPoseConfiguration(vr::ETrackedControllerRole role);
@@ -23,6 +23,10 @@ class KnuckleDeviceDriver::Impl {
 
   void SetDeviceDriver(std::unique_ptr<og::IDevice> device) {
     device_ = std::move(device);
+    device_connected_ = true;
+
+    // steamvr shows the controller as disconnected while the glove is reconnecting
+    device_->ListenForConnectionState([&](og::DeviceConnectionState state) { device_connected_ = state == og::kDeviceConnectionState_Connected; });
 
     device_->ListenForInput([&](og::InputPeripheralData data) {
       // clang-format off
@@ -172,7 +176,10 @@ class KnuckleDeviceDriver::Impl {
 
   void PoseThread() {
     while (is_active_) {
-      vr::VRServerDriverHost()->TrackedDevicePoseUpdated(device_id_, pose_->UpdatePose(), sizeof(vr::DriverPose_t));
+      vr::DriverPose_t pose = pose_->UpdatePose();
+      if (!device_connected_) pose.deviceIsConnected = false;
+
+      vr::VRServerDriverHost()->TrackedDevicePoseUpdated(device_id_, pose, sizeof(vr::DriverPose_t));
 
       std::this_thread::sleep_for(std::chrono::milliseconds(3));
     }
@@ -180,6 +187,7 @@ class KnuckleDeviceDriver::Impl {
 
   std::atomic<uint32_t> device_id_;
   std::atomic<bool> is_active_;
+  std::atomic<bool> device_connected_ = true;
   vr::ETrackedControllerRole role_;
 
   vr::VRBoneTransform_t skeleton_[31]{};
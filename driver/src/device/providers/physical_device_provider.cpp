@@ -26,12 +26,23 @@ static bool InitialiseExternalServices() {
   return CreateBackgroundProcess(bin_path, "opengloves_overlay.exe");
 }
 
+static og::NamedPipeArbitration GetNamedPipeArbitration(const std::string& name) {
+  if (name == "priority") return og::kNamedPipeArbitration_Priority;
+  if (name == "freshest") return og::kNamedPipeArbitration_Freshest;
+
+  if (!name.empty() && name != "last_writer") DriverLog("Unknown named pipe arbitration %s. Forwarding every client instead.", name.c_str());
+  return og::kNamedPipeArbitration_LastWriter;
+}
+
 static og::ServerConfiguration CreateServerConfiguration() {
   auto driver_configuration = GetDriverConfigurationMap();
   auto serial_configuration = GetSerialConfigurationMap();
   auto bluetooth_configuration = GetBluetoothSerialConfigurationMap();
+  auto udp_configuration = GetUdpConfigurationMap();
   auto encoding_configuration = GetAlphaEncodingConfigurationMap();
+  auto binary_encoding_configuration = GetBinaryEncodingConfigurationMap();
   auto namedpipe_configuration = GetNamedPipeConfigurationMap();
+  auto sharedmemory_configuration = GetSharedMemoryConfigurationMap();
 
   std::vector<og::DeviceConfiguration> device_configurations;
 
@@ -45,11 +56,19 @@ static og::ServerConfiguration CreateServerConfiguration() {
                 .serial =
                     {
                         .port_name = std::get<std::string>(serial_configuration["left_port"]),
+                        .baud_rate = static_cast<unsigned int>(std::get<int>(serial_configuration["baud_rate"])),
                     },
                 .bluetooth =
                     {
                         .name = std::get<std::string>(bluetooth_configuration["left_name"]),
                     },
+                .udp =
+                    {
+                        .name = std::get<std::string>(udp_configuration["left_name"]),
+                        .address = std::get<std::string>(udp_configuration["left_address"]),
+                        .port = static_cast<uint16_t>(std::get<int>(udp_configuration["port"])),
+                    },
+                .encoding_type = std::get<bool>(binary_encoding_configuration["left_enabled"]) ? og::kEncodingType_Binary : og::kEncodingType_Alpha,
                 .encoding =
                     {
                         .max_analog_value = static_cast<unsigned int>(std::get<int>(encoding_configuration["max_analog_value"])),
@@ -69,11 +88,19 @@ static og::ServerConfiguration CreateServerConfiguration() {
                 .serial =
                     {
                         .port_name = std::get<std::string>(serial_configuration["right_port"]),
+                        .baud_rate = static_cast<unsigned int>(std::get<int>(serial_configuration["baud_rate"])),
                     },
                 .bluetooth =
                     {
                         .name = std::get<std::string>(bluetooth_configuration["right_name"]),
                     },
+                .udp =
+                    {
+                        .name = std::get<std::string>(udp_configuration["right_name"]),
+                        .address = std::get<std::string>(udp_configuration["right_address"]),
+                        .port = static_cast<uint16_t>(std::get<int>(udp_configuration["port"])),
+                    },
+                .encoding_type = std::get<bool>(binary_encoding_configuration["right_enabled"]) ? og::kEncodingType_Binary : og::kEncodingType_Alpha,
                 .encoding =
                     {
                         .max_analog_value = static_cast<unsigned int>(std::get<int>(encoding_configuration["max_analog_value"])),
@@ -93,9 +120,18 @@ static og::ServerConfiguration CreateServerConfiguration() {
                   {
                       .enabled = std::get<bool>(bluetooth_configuration["enabled"]),
                   },
+              .udp =
+                  {
+                      .enabled = std::get<bool>(udp_configuration["enabled"]),
+                  },
               .named_pipe =
                   {
                       .enabled = std::get<bool>(namedpipe_configuration["enabled"]),
+                      .arbitration = GetNamedPipeArbitration(std::get<std::string>(namedpipe_configuration["arbitration"])),
+                  },
+              .shared_memory =
+                  {
+                      .enabled = std::get<bool>(sharedmemory_configuration["enabled"]),
                   },
           },
       .devices = device_configurations,
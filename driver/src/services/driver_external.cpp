@@ -32,21 +32,36 @@ class DriverExternalServer::Impl {
         std::visit([&](auto&& v) { json[k_btserial_communication_settings_section][key] = v; }, value);
       }
 
-      nlohmann::ordered_map<std::string, std::variant<bool, std::string>> serial_configuration = GetSerialConfigurationMap();
+      nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> serial_configuration = GetSerialConfigurationMap();
       for (auto& [key, value] : serial_configuration) {
         std::visit([&](auto&& v) { json[k_serial_communication_settings_section][key] = v; }, value);
       }
 
-      nlohmann::ordered_map<std::string, std::variant<bool>> namedpipe_configuration = GetNamedPipeConfigurationMap();
+      nlohmann::ordered_map<std::string, std::variant<bool, std::string, int>> udp_configuration = GetUdpConfigurationMap();
+      for (auto& [key, value] : udp_configuration) {
+        std::visit([&](auto&& v) { json[k_udp_communication_settings_section][key] = v; }, value);
+      }
+
+      nlohmann::ordered_map<std::string, std::variant<bool, std::string>> namedpipe_configuration = GetNamedPipeConfigurationMap();
       for (auto& [key, value] : namedpipe_configuration) {
         std::visit([&](auto&& v) { json[k_namedpipe_communication_settings_section][key] = v; }, value);
       }
 
+      nlohmann::ordered_map<std::string, std::variant<bool>> sharedmemory_configuration = GetSharedMemoryConfigurationMap();
+      for (auto& [key, value] : sharedmemory_configuration) {
+        std::visit([&](auto&& v) { json[k_sharedmemory_communication_settings_section][key] = v; }, value);
+      }
+
       nlohmann::ordered_map<std::string, std::variant<int>> alpha_encoding_configuration = GetAlphaEncodingConfigurationMap();
       for (auto& [key, value] : alpha_encoding_configuration) {
         std::visit([&](auto&& v) { json[k_alpha_encoding_settings_section][key] = v; }, value);
       }
 
+      nlohmann::ordered_map<std::string, std::variant<bool>> binary_encoding_configuration = GetBinaryEncodingConfigurationMap();
+      for (auto& [key, value] : binary_encoding_configuration) {
+        std::visit([&](auto&& v) { json[k_binary_encoding_settings_section][key] = v; }, value);
+      }
+
       nlohmann::ordered_map<std::string, std::variant<float, bool>> pose_configuration = GetPoseConfigurationMap();
       for (auto& [key, value] : pose_configuration) {
         std::visit([&](auto&& v) { json[k_pose_settings_section][key] = v; }, value);
@@ -116,8 +131,11 @@ class DriverExternalServer::Impl {
       vr::VRSettings()->RemoveSection(k_driver_settings_section, &err);
       vr::VRSettings()->RemoveSection(k_serial_communication_settings_section, &err);
       vr::VRSettings()->RemoveSection(k_btserial_communication_settings_section, &err);
+      vr::VRSettings()->RemoveSection(k_udp_communication_settings_section, &err);
+      vr::VRSettings()->RemoveSection(k_sharedmemory_communication_settings_section, &err);
       vr::VRSettings()->RemoveSection(k_pose_settings_section, &err);
       vr::VRSettings()->RemoveSection(k_alpha_encoding_settings_section, &err);
+      vr::VRSettings()->RemoveSection(k_binary_encoding_settings_section, &err);
 
       return crow::response(200);
     });
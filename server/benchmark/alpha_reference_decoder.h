@@ -0,0 +1,197 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "communication/encoding/alpha_encoding_service.h"
+#include "opengloves_interface.h"
+
+/**
+ * The original map based Alpha decoder, kept as a reference to compare AlphaEncodingService against. Every packet allocates a map and a string per
+ * key and value, and values are parsed with std::stof/std::stoi.
+ * The original snprintf based encoder is kept alongside it. Both know about the capability keys added since, so that they still describe the same
+ * protocol.
+ */
+namespace alpha_reference {
+  static const std::map<std::string, AlphaEncodingKey> input_key_strings{
+      {"A", kAlphaEncodingKey_ThumbCurl},           {"(AB)", kAlphaEncodingKey_ThumbSplay},       {"B", kAlphaEncodingKey_IndexCurl},
+      {"(BB)", kAlphaEncodingKey_IndexSplay},       {"C", kAlphaEncodingKey_MiddleCurl},          {"(CB)", kAlphaEncodingKey_MiddleSplay},
+      {"D", kAlphaEncodingKey_RingCurl},            {"(DB)", kAlphaEncodingKey_RingSplay},        {"E", kAlphaEncodingKey_PinkyCurl},
+      {"(EB)", kAlphaEncodingKey_PinkySplay},       {"(AAA)", kAlphaEncodingKey_ThumbJoint0},     {"(AAB)", kAlphaEncodingKey_ThumbJoint1},
+      {"(AAC)", kAlphaEncodingKey_ThumbJoint2},     {"(AAD)", kAlphaEncodingKey_ThumbJoint3},     {"(BAA)", kAlphaEncodingKey_IndexJoint0},
+      {"(BAB)", kAlphaEncodingKey_IndexJoint1},     {"(BAC)", kAlphaEncodingKey_IndexJoint2},     {"(BAD)", kAlphaEncodingKey_IndexJoint3},
+      {"(CAA)", kAlphaEncodingKey_MiddleJoint0},    {"(CAB)", kAlphaEncodingKey_MiddleJoint1},    {"(CAC)", kAlphaEncodingKey_MiddleJoint2},
+      {"(CAD)", kAlphaEncodingKey_MiddleJoint3},    {"(DAA)", kAlphaEncodingKey_RingJoint0},      {"(DAB)", kAlphaEncodingKey_RingJoint1},
+      {"(DAC)", kAlphaEncodingKey_RingJoint2},      {"(DAD)", kAlphaEncodingKey_RingJoint3},      {"(EAA)", kAlphaEncodingKey_PinkyJoint0},
+      {"(EAB)", kAlphaEncodingKey_PinkyJoint1},     {"(EAC)", kAlphaEncodingKey_PinkyJoint2},     {"(EAD)", kAlphaEncodingKey_PinkyJoint3},
+      {"F", kAlphaEncodingKey_MainJoystick_X},      {"G", kAlphaEncodingKey_MainJoystick_Y},      {"H", kAlphaEncodingKey_MainJoystick_Click},
+      {"I", kAlphaEncodingKey_Trigger_Click},       {"J", kAlphaEncodingKey_A_Click},             {"K", kAlphaEncodingKey_B_Click},
+      {"L", kAlphaEncodingKey_Grab_Gesture},        {"M", kAlphaEncodingKey_Pinch_Gesture},       {"N", kAlphaEncodingKey_Menu_Click},
+      {"O", kAlphaEncodingKey_Calibration_Click},   {"P", kAlphaEncodingKey_Trigger_Value},       {"Z", kAlphaEncodingKey_Info},
+      {"(ZV)", kAlphaEncodingKey_Info_FWVersion},   {"(ZG)", kAlphaEncodingKey_Info_DeviceType},  {"(ZH)", kAlphaEncodingKey_Info_Hand},
+      {"(ZE)", kAlphaEncodingKey_Info_Encodings},   {"(ZB)", kAlphaEncodingKey_Info_AnalogResolution},
+  };
+
+  static const std::string key_characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ()";
+
+  inline bool IsKeyCharacter(const char character) {
+    return key_characters.find(character) != std::string::npos;
+  }
+
+  inline bool IsDigit(const char character) {
+    return character >= '0' && character <= '9';
+  }
+
+  inline std::map<AlphaEncodingKey, std::string> ParseToMap(const std::string& buff) {
+    std::map<AlphaEncodingKey, std::string> result;
+
+    size_t i = 0;
+    while (i < buff.length()) {
+      std::string current_key;
+
+      if (buff[i] == '(') {
+        while (i < buff.length() && IsKeyCharacter(buff[i])) current_key += buff[i++];
+      } else if (IsKeyCharacter(buff[i])) {
+        current_key = buff[i++];
+      } else {
+        i++;
+        continue;
+      }
+
+      std::string current_value;
+      while (i < buff.length() && IsDigit(buff[i])) current_value += buff[i++];
+
+      if (const auto it = input_key_strings.find(current_key); it != input_key_strings.end()) result.insert_or_assign(it->second, current_value);
+    }
+
+    return result;
+  }
+
+  inline og::Input DecodePacket(const std::string& buff, const unsigned int max_analog_value) {
+    og::Input result{};
+
+    const auto contains = [](const std::map<AlphaEncodingKey, std::string>& map, AlphaEncodingKey key) { return map.contains(key); };
+
+    try {
+      const std::map<AlphaEncodingKey, std::string> input_map = ParseToMap(buff);
+
+      if (contains(input_map, kAlphaEncodingKey_Info)) {
+        og::InputInfoData info{};
+        if (contains(input_map, kAlphaEncodingKey_Info_FWVersion)) info.firmware_version = std::stoi(input_map.at(kAlphaEncodingKey_Info_FWVersion));
+        if (contains(input_map, kAlphaEncodingKey_Info_DeviceType))
+          info.device_type = static_cast<og::DeviceType>(std::stoi(input_map.at(kAlphaEncodingKey_Info_DeviceType)));
+        if (contains(input_map, kAlphaEncodingKey_Info_Hand)) info.hand = static_cast<og::Hand>(std::stoi(input_map.at(kAlphaEncodingKey_Info_Hand)));
+        if (contains(input_map, kAlphaEncodingKey_Info_Encodings))
+          info.supported_encodings = static_cast<uint32_t>(std::stoi(input_map.at(kAlphaEncodingKey_Info_Encodings)));
+        if (contains(input_map, kAlphaEncodingKey_Info_AnalogResolution))
+          info.max_analog_resolution = std::stoi(input_map.at(kAlphaEncodingKey_Info_AnalogResolution));
+
+        if (info == og::InputInfoData{}) throw std::runtime_error("Info packet was empty.");
+
+        result.type = og::kInputDataType_Info;
+        result.data.info = info;
+        return result;
+      }
+
+      og::InputPeripheralData peripheral{};
+
+      std::array<float, 5> flexion{};
+      flexion.fill(-1.0f);
+      for (int i = 0; i < 5; i++) {
+        const auto key = static_cast<AlphaEncodingKey>(kAlphaEncodingKey_ThumbCurl + i * 2);
+        if (contains(input_map, key)) flexion[i] = std::stof(input_map.at(key)) / max_analog_value;
+      }
+
+      for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 4; j++) {
+          const auto key = static_cast<AlphaEncodingKey>(kAlphaEncodingKey_ThumbJoint0 + i * 4 + j);
+          peripheral.flexion[i][j] = contains(input_map, key) ? std::stof(input_map.at(key)) / max_analog_value : flexion[i];
+        }
+      }
+
+      for (int i = 0; i < 5; i++) {
+        const auto key = static_cast<AlphaEncodingKey>(kAlphaEncodingKey_ThumbSplay + i * 2);
+        if (contains(input_map, key)) peripheral.splay[i] = (std::stof(input_map.at(key)) / max_analog_value - 0.5f) * 2.0f;
+      }
+
+      if (contains(input_map, kAlphaEncodingKey_MainJoystick_X))
+        peripheral.joystick.x = 2 * std::stof(input_map.at(kAlphaEncodingKey_MainJoystick_X)) / max_analog_value - 1;
+      if (contains(input_map, kAlphaEncodingKey_MainJoystick_Y))
+        peripheral.joystick.y = 2 * std::stof(input_map.at(kAlphaEncodingKey_MainJoystick_Y)) / max_analog_value - 1;
+      if (contains(input_map, kAlphaEncodingKey_Trigger_Value))
+        peripheral.trigger.value = std::stof(input_map.at(kAlphaEncodingKey_Trigger_Value)) / max_analog_value;
+
+      peripheral.joystick.pressed = contains(input_map, kAlphaEncodingKey_MainJoystick_Click);
+      peripheral.trigger.pressed = contains(input_map, kAlphaEncodingKey_Trigger_Click);
+      peripheral.A.pressed = contains(input_map, kAlphaEncodingKey_A_Click);
+      peripheral.B.pressed = contains(input_map, kAlphaEncodingKey_B_Click);
+      peripheral.grab.activated = contains(input_map, kAlphaEncodingKey_Grab_Gesture);
+      peripheral.pinch.activated = contains(input_map, kAlphaEncodingKey_Pinch_Gesture);
+      peripheral.menu.pressed = contains(input_map, kAlphaEncodingKey_Menu_Click);
+      peripheral.calibrate.pressed = contains(input_map, kAlphaEncodingKey_Calibration_Click);
+
+      if (peripheral == og::InputPeripheralData{}) throw std::runtime_error("Peripheral packet was empty.");
+
+      result.type = og::kInputDataType_Peripheral;
+      result.data.peripheral = peripheral;
+      return result;
+    } catch (const std::exception&) {
+      result.type = og::kInputDataType_Invalid;
+      return result;
+    }
+  }
+
+  template <typename... Args>
+  std::string StringFormat(const std::string& format, Args... args) {
+    const int size = std::snprintf(nullptr, 0, format.c_str(), args...) + 1;
+    if (size <= 0) return "";
+
+    const auto buf = std::make_unique<char[]>(size);
+    std::snprintf(buf.get(), size, format.c_str(), args...);
+
+    return std::string(buf.get(), buf.get() + size - 1);
+  }
+
+  inline std::string EncodePacket(const og::Output& output) {
+    switch (output.type) {
+      case og::kOutputDataType_FetchInfo: {
+        std::string result;
+        if (output.data.fetch_info.start_streaming) result += "(ZA)";
+        if (output.data.fetch_info.get_info) result += "Z";
+
+        return result;
+      }
+
+      case og::kOutputData_Type_ForceFeedback: {
+        const og::OutputForceFeedbackData& data = output.data.force_feedback_data;
+
+        return StringFormat("A%dB%dC%dD%dE%d\n", data.thumb, data.index, data.middle, data.ring, data.pinky);
+      }
+
+      case og::kOutputDataType_Haptic: {
+        const og::OutputHapticData& data = output.data.haptic_data;
+
+        return StringFormat("F%.2fG%.2fH%.2f\n", data.frequency, data.duration, data.amplitude);
+      }
+
+      case og::kOutputDataType_Configure: {
+        const og::OutputConfigureData& data = output.data.configure;
+
+        return StringFormat("(ZE)%d(ZB)%d\n", data.encoding, data.analog_resolution);
+      }
+
+      default:
+        return "\n";
+    }
+  }
+}  // namespace alpha_reference
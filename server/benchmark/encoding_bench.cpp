@@ -0,0 +1,325 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alpha_reference_decoder.h"
+#include "communication/encoding/alpha_encoding_service.h"
+#include "communication/encoding/binary_encoding_service.h"
+#include "opengloves_interface.h"
+
+static constexpr unsigned int max_analog_value = 4095;
+
+struct BenchmarkPacket {
+  const char* name;
+  std::string packet;
+
+  og::DecodeStatus expected_status;
+  // the reference decoder treats empty packets and very large values differently
+  bool matches_reference;
+};
+
+static const std::vector<BenchmarkPacket> benchmark_packets = {
+    {"full_joint",
+     "(AAA)1024(AAB)2048(AAC)3072(AAD)4095(BAA)512(BAB)1536(BAC)2560(BAD)3584(CAA)100(CAB)200(CAC)300(CAD)400(DAA)4000(DAB)3000(DAC)2000(DAD)1000"
+     "(EAA)50(EAB)60(EAC)70(EAD)80(AB)2047(BB)2048(CB)2049(DB)2050(EB)2051F2047G2048HP4095IJL\n",
+     og::kDecodeStatus_Ok,
+     true},
+    {"whole_finger", "A1024B2048C3072D4095E0F2047G2048P100IJ\n", og::kDecodeStatus_Ok, true},
+    {"info", "Z(ZV)3(ZG)0(ZH)1\n", og::kDecodeStatus_Ok, true},
+    {"capabilities", "Z(ZV)4(ZG)0(ZH)0(ZE)3(ZB)12\n", og::kDecodeStatus_Ok, true},
+
+    // malformed packets, as seen on a noisy connection
+    {"unknown_key", "A1024B2048(XYZ)55C3072Q12D4095E0F2047G2048\n", og::kDecodeStatus_UnknownKey, true},
+    {"truncated", "A1024B2048C3072D4095E0F2047(AA\n", og::kDecodeStatus_Truncated, true},
+    {"missing_value", "A1024BC3072D4095E0F2047G2048\n", og::kDecodeStatus_MissingValue, true},
+    {"overflow", "A1024B2048C30720000000000D4095E0\n", og::kDecodeStatus_NumberOverflow, false},
+    {"garbage", "\x7f\x13;;9981 .,\xfe\n", og::kDecodeStatus_Empty, false},
+};
+
+struct BenchmarkOutput {
+  const char* name;
+  og::Output output;
+};
+
+static const std::vector<BenchmarkOutput> benchmark_outputs = {
+    {"force_feedback", {.type = og::kOutputData_Type_ForceFeedback, .data = {.force_feedback_data = {1000, 200, 300, 400, 500}}}},
+    {"haptic", {.type = og::kOutputDataType_Haptic, .data = {.haptic_data = {.duration = 0.25f, .frequency = 180.0f, .amplitude = 0.8f}}}},
+    {"fetch_info", {.type = og::kOutputDataType_FetchInfo, .data = {.fetch_info = {.start_streaming = true, .get_info = true}}}},
+    {"configure", {.type = og::kOutputDataType_Configure, .data = {.configure = {.encoding = og::kEncodingType_Binary, .analog_resolution = 0}}}},
+};
+
+static bool InputsMatch(const og::Input& a, const og::Input& b) {
+  if (a.type != b.type) return false;
+
+  switch (a.type) {
+    case og::kInputDataType_Info:
+      return a.data.info == b.data.info;
+    case og::kInputDataType_Peripheral:
+      return a.data.peripheral == b.data.peripheral;
+    default:
+      return true;
+  }
+}
+
+// binary frames quantise every analog value to 12 bits, and send defaults (ie. a centred splay) for values alpha packets leave out
+static bool InputsNearlyMatch(const og::Input& a, const og::Input& b) {
+  if (a.type != b.type || a.type != og::kInputDataType_Peripheral) return InputsMatch(a, b);
+
+  const og::InputPeripheralData& x = a.data.peripheral;
+  const og::InputPeripheralData& y = b.data.peripheral;
+  const auto near = [](const float p, const float q) { return std::fabs(p - q) <= 1e-3f; };
+
+  for (int i = 0; i < 5; i++) {
+    for (int j = 0; j < 4; j++) {
+      if (!near(x.flexion[i][j], y.flexion[i][j])) return false;
+    }
+    if (!near(x.splay[i], y.splay[i])) return false;
+  }
+
+  return near(x.joystick.x, y.joystick.x) && near(x.joystick.y, y.joystick.y) && near(x.trigger.value, y.trigger.value) &&
+         x.joystick.pressed == y.joystick.pressed && x.trigger.pressed == y.trigger.pressed && x.A == y.A && x.B == y.B && x.grab == y.grab &&
+         x.pinch == y.pinch && x.menu == y.menu && x.calibrate == y.calibrate;
+}
+
+template <typename Function>
+static double NanosecondsPerCall(const size_t iterations, Function&& function) {
+  const auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) function();
+  const auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(iterations);
+}
+
+// decodes a stream of packets in read sized chunks (ie. as from a transport or a capture file), returning the time taken per packet
+static double StreamNanosecondsPerPacket(IEncodingService& encoding_service, const std::string& stream, size_t stream_packets, size_t iterations) {
+  std::array<og::Input, 16> stream_inputs{};
+  std::array<og::DecodeStatus, 16> stream_statuses{};
+  static constexpr size_t stream_chunk_size = 512;
+
+  const size_t stream_iterations = std::max<size_t>(1, iterations / stream_packets);
+  const double stream_ns = NanosecondsPerCall(stream_iterations, [&] {
+    for (size_t offset = 0; offset < stream.length(); offset += stream_chunk_size) {
+      std::string_view chunk = std::string_view(stream).substr(offset, stream_chunk_size);
+      while (!chunk.empty()) chunk.remove_prefix(encoding_service.DecodeChunk(chunk, stream_inputs, stream_statuses).consumed);
+    }
+  });
+
+  return stream_ns / static_cast<double>(stream_packets);
+}
+
+int main(int argc, char** argv) {
+  size_t iterations = 200000;
+  if (argc > 1) iterations = std::strtoull(argv[1], nullptr, 10);
+
+  AlphaEncodingService encoding_service({max_analog_value});
+
+  std::printf("%-16s %14s %14s %14s\n", "packet", "ns/packet", "packets/sec", "reference ns");
+
+  int mismatches = 0;
+  for (const auto& [name, packet, expected_status, matches_reference] : benchmark_packets) {
+    og::Input decoded{};
+    if (encoding_service.DecodePacket(packet, decoded) != expected_status) {
+      std::printf("%s: decoded packet did not have the expected status\n", name);
+      mismatches++;
+    }
+
+    const og::Input reference = alpha_reference::DecodePacket(packet, max_analog_value);
+    if (matches_reference && !InputsMatch(decoded, reference)) {
+      std::printf("%s: decoded packet does not match the reference decoder\n", name);
+      mismatches++;
+    }
+
+    volatile og::InputDataType sink;
+    const double decode_ns = NanosecondsPerCall(iterations, [&] {
+      encoding_service.DecodePacket(packet, decoded);
+      sink = decoded.type;
+    });
+    const double reference_ns = NanosecondsPerCall(iterations, [&] { sink = alpha_reference::DecodePacket(packet, max_analog_value).type; });
+
+    std::printf("%-16s %14.1f %14.0f %14.1f\n", name, decode_ns, 1e9 / decode_ns, reference_ns);
+  }
+
+  // every packet back to back, decoded as a stream
+  std::string stream;
+  size_t stream_packets = 0;
+  for (int i = 0; i < 64; i++) {
+    for (const auto& benchmark_packet : benchmark_packets) {
+      stream += benchmark_packet.packet;
+      stream_packets++;
+    }
+  }
+
+  // decoded as a stream, it must decode the same as a packet at a time. Checked in small odd sized chunks, so that packets are split at every point
+  static constexpr size_t check_chunk_size = 37;
+  std::array<og::Input, 16> stream_inputs{};
+  std::array<og::DecodeStatus, 16> stream_statuses{};
+  size_t stream_checked = 0;
+  for (std::string_view chunk = stream; !chunk.empty();) {
+    const DecodeChunkResult result = encoding_service.DecodeChunk(chunk.substr(0, check_chunk_size), stream_inputs, stream_statuses);
+    chunk.remove_prefix(result.consumed);
+
+    for (size_t i = 0; i < result.emitted; i++, stream_checked++) {
+      const BenchmarkPacket& benchmark_packet = benchmark_packets[stream_checked % benchmark_packets.size()];
+
+      og::Input expected{};
+      if (stream_statuses[i] != encoding_service.DecodePacket(benchmark_packet.packet, expected) || !InputsMatch(stream_inputs[i], expected)) {
+        std::printf("%s: stream did not decode the same as the packet\n", benchmark_packet.name);
+        mismatches++;
+      }
+    }
+  }
+  if (stream_checked != stream_packets) {
+    std::printf("stream decoded %zu of %zu packets\n", stream_checked, stream_packets);
+    mismatches++;
+  }
+
+  const double stream_ns = StreamNanosecondsPerPacket(encoding_service, stream, stream_packets, iterations);
+  std::printf("%-16s %14.1f %14.0f %14s\n", "stream", stream_ns, 1e9 / stream_ns, "-");
+
+  // the valid packets again as binary frames, with the size of each encoding on the wire
+  BinaryEncodingService binary_service;
+  og::Input decoded_full_joint{};
+
+  std::printf("\n%-16s %14s %14s %14s\n", "binary packet", "ns/packet", "packets/sec", "bytes (alpha)");
+
+  std::string binary_stream;
+  size_t binary_stream_packets = 0;
+  for (const auto& [name, packet, expected_status, matches_reference] : benchmark_packets) {
+    if (expected_status != og::kDecodeStatus_Ok) continue;
+
+    og::Input input{};
+    encoding_service.DecodePacket(packet, input);
+
+    std::array<char, 64> frame_buffer{};
+    size_t frame_length;
+    if (!BinaryEncodingService::EncodeInput(input, static_cast<uint8_t>(binary_stream_packets), frame_buffer, frame_length)) {
+      std::printf("%s: failed to encode binary frame\n", name);
+      mismatches++;
+      continue;
+    }
+    const std::string frame(frame_buffer.data(), frame_length);
+
+    og::Input decoded{};
+    if (binary_service.DecodePacket(frame, decoded) != og::kDecodeStatus_Ok || !InputsNearlyMatch(decoded, input)) {
+      std::printf("%s: binary frame did not decode to the same input\n", name);
+      mismatches++;
+    }
+
+    // a corrupted byte must be caught by the checksum, and a cut off frame rejected
+    std::string corrupted = frame;
+    corrupted[corrupted.length() / 2] ^= 0x10;
+    if (binary_service.DecodePacket(corrupted, decoded) == og::kDecodeStatus_Ok || decoded.type != og::kInputDataType_Invalid) {
+      std::printf("%s: corrupted binary frame was not rejected\n", name);
+      mismatches++;
+    }
+    if (binary_service.DecodePacket(frame.substr(0, frame.length() - 4), decoded) == og::kDecodeStatus_Ok) {
+      std::printf("%s: truncated binary frame was not rejected\n", name);
+      mismatches++;
+    }
+
+    volatile og::InputDataType sink;
+    const double decode_ns = NanosecondsPerCall(iterations, [&] {
+      binary_service.DecodePacket(frame, decoded);
+      sink = decoded.type;
+    });
+
+    std::printf("%-16s %14.1f %14.0f %6zu (%4zu)\n", name, decode_ns, 1e9 / decode_ns, frame.length(), packet.length());
+
+    for (int i = 0; i < 64; i++) binary_stream += frame;
+    binary_stream_packets += 64;
+  }
+
+  const double binary_stream_ns = StreamNanosecondsPerPacket(binary_service, binary_stream, binary_stream_packets, iterations);
+  std::printf("%-16s %14.1f %14.0f %14s\n", "stream", binary_stream_ns, 1e9 / binary_stream_ns, "-");
+
+  // a hand moving slowly, two channels change between frames. Sent as keyframes only, then as a keyframe every 32 frames with deltas between
+  std::vector<og::InputPeripheralData> motion(512);
+  encoding_service.DecodePacket(benchmark_packets[0].packet, decoded_full_joint);
+  for (size_t i = 0; i < motion.size(); i++) {
+    motion[i] = i == 0 ? decoded_full_joint.data.peripheral : motion[i - 1];
+    motion[i].flexion[i % 5][1] = static_cast<float>(i % 64) / 64.0f;
+    motion[i].trigger.value = static_cast<float>(i % 128) / 128.0f;
+  }
+
+  std::string keyframe_stream, delta_stream;
+  for (size_t i = 0; i < motion.size(); i++) {
+    std::array<char, 64> frame_buffer{};
+    size_t frame_length;
+
+    const og::Input input = {.data = {.peripheral = motion[i]}, .type = og::kInputDataType_Peripheral};
+    BinaryEncodingService::EncodeInput(input, static_cast<uint8_t>(i), frame_buffer, frame_length);
+    keyframe_stream.append(frame_buffer.data(), frame_length);
+
+    if (i % 32 != 0) BinaryEncodingService::EncodeDelta(motion[i - 1], motion[i], static_cast<uint8_t>(i), frame_buffer, frame_length);
+    delta_stream.append(frame_buffer.data(), frame_length);
+  }
+
+  // the deltas must rebuild every frame
+  {
+    BinaryEncodingService delta_service;
+    std::array<og::Input, 1> inputs{};
+    std::array<og::DecodeStatus, 1> statuses{};
+
+    size_t frame = 0;
+    for (std::string_view chunk = delta_stream; !chunk.empty();) {
+      const DecodeChunkResult result = delta_service.DecodeChunk(chunk, inputs, statuses);
+      chunk.remove_prefix(result.consumed);
+      if (result.emitted == 0) continue;
+
+      const og::Input expected = {.data = {.peripheral = motion[frame++]}, .type = og::kInputDataType_Peripheral};
+      if (statuses[0] != og::kDecodeStatus_Ok || !InputsNearlyMatch(inputs[0], expected)) {
+        std::printf("delta frame %zu did not decode to the same input\n", frame - 1);
+        mismatches++;
+        break;
+      }
+    }
+  }
+
+  BinaryEncodingService keyframe_service, delta_service;
+  const double keyframe_ns = StreamNanosecondsPerPacket(keyframe_service, keyframe_stream, motion.size(), iterations);
+  const double delta_ns = StreamNanosecondsPerPacket(delta_service, delta_stream, motion.size(), iterations);
+  const auto keyframe_bytes = static_cast<double>(keyframe_stream.length()) / static_cast<double>(motion.size());
+  const auto delta_bytes = static_cast<double>(delta_stream.length()) / static_cast<double>(motion.size());
+  std::printf("%-16s %14.1f %14.0f %14.1f\n", "keyframe_stream", keyframe_ns, 1e9 / keyframe_ns, keyframe_bytes);
+  std::printf("%-16s %14.1f %14.0f %14.1f\n", "delta_stream", delta_ns, 1e9 / delta_ns, delta_bytes);
+
+  std::printf("\n%-16s %14s %14s %14s %14s\n", "output", "ns/packet", "packets/sec", "reference ns", "binary ns");
+
+  std::array<char, 128> encode_buffer{};
+  for (const auto& [name, output] : benchmark_outputs) {
+    size_t encoded_length = 0;
+    encoding_service.EncodePacket(output, encode_buffer, encoded_length);
+    if (std::string_view(encode_buffer.data(), encoded_length) != alpha_reference::EncodePacket(output)) {
+      std::printf("%s: encoded output does not match the reference encoder\n", name);
+      mismatches++;
+    }
+
+    volatile size_t sink;
+    const double encode_ns = NanosecondsPerCall(iterations, [&] {
+      encoding_service.EncodePacket(output, encode_buffer, encoded_length);
+      sink = encoded_length;
+    });
+    const double reference_ns = NanosecondsPerCall(iterations, [&] { sink = alpha_reference::EncodePacket(output).length(); });
+    const double binary_ns = NanosecondsPerCall(iterations, [&] {
+      binary_service.EncodePacket(output, encode_buffer, encoded_length);
+      sink = encoded_length;
+    });
+
+    std::printf("%-16s %14.1f %14.0f %14.1f %14.1f\n", name, encode_ns, 1e9 / encode_ns, reference_ns, binary_ns);
+  }
+
+  return mismatches == 0 ? 0 : 1;
+}
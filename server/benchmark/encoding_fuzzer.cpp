@@ -0,0 +1,135 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alpha_reference_decoder.h"
+#include "communication/encoding/alpha_encoding_service.h"
+#include "communication/encoding/binary_encoding_service.h"
+#include "opengloves_interface.h"
+
+/**
+ * libFuzzer target for the decoders. Every input is:
+ *  - decoded as a single Alpha packet and compared against the original map based decoder
+ *  - decoded as an Alpha stream, split at a point taken from the input, and compared against decoding each line on its own
+ *  - decoded as a Binary stream in the same way, and compared against decoding each frame on its own
+ * Any difference aborts, so that libFuzzer saves the input that caused it.
+ */
+
+static constexpr unsigned int max_analog_value = 4095;
+
+static bool InputsMatch(const og::Input& a, const og::Input& b) {
+  if (a.type != b.type) return false;
+
+  switch (a.type) {
+    case og::kInputDataType_Info:
+      return a.data.info == b.data.info;
+    case og::kInputDataType_Peripheral:
+      return a.data.peripheral == b.data.peripheral;
+    default:
+      return true;
+  }
+}
+
+static bool IsEmptyData(const og::Input& input) {
+  switch (input.type) {
+    case og::kInputDataType_Info:
+      return input.data.info == og::InputInfoData{};
+    case og::kInputDataType_Peripheral:
+      return input.data.peripheral == og::InputPeripheralData{};
+    default:
+      return false;
+  }
+}
+
+[[noreturn]] static void Fail(const char* message, std::string_view packet) {
+  std::fprintf(stderr, "%s: '%.*s'\n", message, static_cast<int>(packet.length()), packet.data());
+  std::abort();
+}
+
+// the differences to the reference decoder are intentional:
+//  - packets without any data are rejected as empty, rather than decoding to default values
+//  - values that do not fit into 32 bits are rejected, rather than rounded by std::stof
+//  - the reference decoder rejects packets where every value is zero
+static void CompareWithReference(AlphaEncodingService& encoding_service, std::string_view packet) {
+  og::Input decoded{};
+  const og::DecodeStatus status = encoding_service.DecodePacket(packet, decoded);
+
+  if (status >= og::kDecodeStatus_Max) Fail("Invalid decode status", packet);
+  if ((decoded.type == og::kInputDataType_Invalid) != (status == og::kDecodeStatus_Empty || status == og::kDecodeStatus_MissingValue ||
+                                                       status == og::kDecodeStatus_NumberOverflow))
+    Fail("Decode status does not match the input type", packet);
+
+  if (status == og::kDecodeStatus_Empty || status == og::kDecodeStatus_NumberOverflow) return;
+
+  const og::Input reference = alpha_reference::DecodePacket(std::string(packet), max_analog_value);
+  if (reference.type == og::kInputDataType_Invalid && decoded.type != og::kInputDataType_Invalid && IsEmptyData(decoded)) return;
+
+  if (!InputsMatch(decoded, reference)) Fail("Decoded packet does not match the reference decoder", packet);
+}
+
+// binary streams skip empty frames (repeated delimiters) rather than emitting them
+static void CompareStreamWithPackets(
+    IEncodingService& packet_service, IEncodingService& stream_service, std::string_view data, size_t split, char delimiter, bool skip_empty) {
+  std::vector<og::Input> stream_inputs;
+  std::vector<og::DecodeStatus> stream_statuses;
+
+  // a small output span so that decoding also has to stop and resume when it is full
+  std::array<og::Input, 2> inputs{};
+  std::array<og::DecodeStatus, 2> statuses{};
+  for (std::string_view chunk : {data.substr(0, split), data.substr(split)}) {
+    while (!chunk.empty()) {
+      const DecodeChunkResult result = stream_service.DecodeChunk(chunk, inputs, statuses);
+      if (result.consumed == 0 && result.emitted == 0) Fail("Stream decoder made no progress", data);
+
+      stream_inputs.insert(stream_inputs.end(), inputs.begin(), inputs.begin() + result.emitted);
+      stream_statuses.insert(stream_statuses.end(), statuses.begin(), statuses.begin() + result.emitted);
+      chunk.remove_prefix(result.consumed);
+    }
+  }
+
+  size_t packet_count = 0;
+  for (size_t begin = 0, end; (end = data.find(delimiter, begin)) != std::string_view::npos; begin = end + 1) {
+    if (skip_empty && end == begin) continue;
+    if (packet_count >= stream_inputs.size()) Fail("Stream decoder emitted too few packets", data);
+
+    og::Input decoded{};
+    const og::DecodeStatus status = packet_service.DecodePacket(data.substr(begin, end - begin), decoded);
+    if (status != stream_statuses[packet_count] || !InputsMatch(decoded, stream_inputs[packet_count]))
+      Fail("Stream decoder does not match decoding packets one at a time", data);
+
+    packet_count++;
+  }
+
+  if (packet_count != stream_inputs.size()) Fail("Stream decoder emitted too many packets", data);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  static AlphaEncodingService encoding_service({max_analog_value});
+
+  const std::string_view input(reinterpret_cast<const char*>(data), size);
+
+  const size_t split = size == 0 ? 0 : data[0] % (size + 1);
+
+  CompareWithReference(encoding_service, input);
+
+  AlphaEncodingService alpha_packet_service({max_analog_value});
+  AlphaEncodingService alpha_stream_service({max_analog_value});
+  CompareStreamWithPackets(alpha_packet_service, alpha_stream_service, input, split, '\n', false);
+
+  BinaryEncodingService binary_packet_service;
+  BinaryEncodingService binary_stream_service;
+  CompareStreamWithPackets(binary_packet_service, binary_stream_service, input, split, '\0', true);
+
+  return 0;
+}
@@ -0,0 +1,776 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "communication/encoding/binary_encoding_service.h"
+#include "communication/probers/hotplug_watcher.h"
+#include "communication/probers/prober_udp_announcement.h"
+#include "communication/services/service_serial.h"
+#include "communication/services/service_stream_socket.h"
+#include "communication/services/service_udp.h"
+#include "ipc/ipc_listener.h"
+#include "opengloves_interface.h"
+#include "shared_memory/shared_memory_input.h"
+
+// the same read size the hardware communication manager uses
+static constexpr size_t receive_buffer_length = 4096;
+
+// how often force feedback is written while the device streams, as a game would
+static constexpr auto force_feedback_interval = std::chrono::milliseconds(1);
+
+// stands in for a bluetooth device, over one end of a connected pair of sockets
+class SocketPairCommunicationService : public StreamSocketCommunicationService {
+ public:
+  explicit SocketPairCommunicationService(const int socket)
+      : StreamSocketCommunicationService(127, std::chrono::milliseconds(500)), socket_(socket) {
+    Connect();
+  }
+
+  std::string GetIdentifier() override {
+    return "socketpair";
+  }
+
+  ~SocketPairCommunicationService() override {
+    Disconnect();
+  }
+
+ protected:
+  bool OpenSocket(SocketHandle& out_socket) override {
+    out_socket = socket_;
+
+    return true;
+  }
+
+ private:
+  int socket_;
+};
+
+// stands in for a device over tcp, so that the cost of a real network stack (and nagle) is seen
+class LoopbackCommunicationService : public StreamSocketCommunicationService {
+ public:
+  explicit LoopbackCommunicationService(const uint16_t port) : StreamSocketCommunicationService(127, std::chrono::milliseconds(500)), port_(port) {
+    Connect();
+  }
+
+  std::string GetIdentifier() override {
+    return "loopback";
+  }
+
+  ~LoopbackCommunicationService() override {
+    Disconnect();
+  }
+
+ protected:
+  bool OpenSocket(SocketHandle& out_socket) override {
+    out_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port_);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(out_socket, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0) {
+      LogError("Failed to connect to loopback device");
+      close(out_socket);
+
+      return false;
+    }
+
+    const int no_delay = 1;
+    setsockopt(out_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof no_delay);
+
+    return true;
+  }
+
+ private:
+  uint16_t port_;
+};
+
+struct TransportResult {
+  size_t expected_samples;
+  size_t samples;
+  size_t decode_errors;
+  double seconds;
+  CommunicationServiceStatistics statistics;
+  std::vector<double> write_us;
+
+  double max_delivery_us;  // longest from a sample being sent to it being handled, where that is measured
+};
+
+// the device streams frames from its end of the link (a socket or pseudo terminal) while force feedback is written to it. frame_interval of zero
+// sends as fast as it can
+static TransportResult RunTransport(
+    ICommunicationService& service,
+    const int device_fd,
+    const std::string& frames,
+    const size_t frame_count,
+    const std::chrono::microseconds frame_interval) {
+  const size_t frame_length = frames.length() / frame_count;
+
+  std::atomic<bool> streaming = true;
+
+  std::thread device_thread([&] {
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frame_count; frame++) {
+      if (frame_interval.count() > 0) std::this_thread::sleep_until(begin + frame_interval * frame);
+
+      for (size_t sent = 0; sent < frame_length;) {
+        const ssize_t result = write(device_fd, frames.data() + frame * frame_length + sent, frame_length - sent);
+        if (result <= 0) return;
+        sent += static_cast<size_t>(result);
+      }
+    }
+  });
+
+  // the device has to take the force feedback off its end, or the writes would eventually block
+  std::atomic<bool> draining = true;
+  std::thread device_drain_thread([&] {
+    std::array<char, receive_buffer_length> drain{};
+    while (draining) {
+      pollfd readable{.fd = device_fd, .events = POLLIN, .revents = 0};
+      if (poll(&readable, 1, 50) > 0 && read(device_fd, drain.data(), drain.size()) <= 0) return;
+    }
+  });
+
+  TransportResult result{};
+
+  std::thread writer_thread([&] {
+    BinaryEncodingService encoding_service;
+    std::array<char, 64> output_buffer{};
+
+    for (int16_t i = 0; streaming; i++) {
+      const og::Output output = {.type = og::kOutputData_Type_ForceFeedback, .data = {.force_feedback_data = {i, i, i, i, i}}};
+      size_t output_length;
+      encoding_service.EncodePacket(output, output_buffer, output_length);
+
+      const auto write_begin = std::chrono::steady_clock::now();
+      if (!service.RawWrite(std::string_view(output_buffer.data(), output_length))) break;
+      result.write_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - write_begin).count());
+
+      std::this_thread::sleep_for(force_feedback_interval);
+    }
+  });
+
+  BinaryEncodingService encoding_service;
+  std::array<char, receive_buffer_length> buffer{};
+  std::array<og::Input, 64> inputs{};
+  std::array<og::DecodeStatus, 64> statuses{};
+
+  const auto begin = std::chrono::steady_clock::now();
+  while (result.samples + result.decode_errors < frame_count) {
+    size_t bytes_read;
+    if (!service.ReceiveNextChunk(buffer, bytes_read)) break;
+
+    for (std::string_view chunk(buffer.data(), bytes_read); !chunk.empty();) {
+      const DecodeChunkResult decoded = encoding_service.DecodeChunk(chunk, inputs, statuses);
+      chunk.remove_prefix(decoded.consumed);
+
+      for (size_t i = 0; i < decoded.emitted; i++) {
+        if (statuses[i] == og::kDecodeStatus_Ok) {
+          result.samples++;
+        } else {
+          result.decode_errors++;
+        }
+      }
+    }
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  streaming = false;
+  writer_thread.join();
+  device_thread.join();
+
+  result.statistics = service.GetStatistics();
+  result.expected_samples = frame_count;
+
+  draining = false;
+  device_drain_thread.join();
+  close(device_fd);
+
+  return result;
+}
+
+// what the network does to the device's datagrams on the way
+struct UdpImpairment {
+  bool lose;       // every 20th is lost
+  bool reorder;    // every 10th is overtaken by the one after it, so arrives late
+  bool duplicate;  // every 10th arrives twice
+};
+
+static void WriteUdpHeader(const uint32_t sequence, char* out_header) {
+  for (size_t i = 0; i < udp_header_length; i++) out_header[i] = static_cast<char>(sequence >> (i * 8));
+}
+
+// as RunTransport, but the device sends each frame in a datagram of its own, once it has heard from the server
+static TransportResult RunUdpTransport(
+    ICommunicationService& service,
+    const int device_socket,
+    const std::string& frames,
+    const size_t frame_count,
+    const std::chrono::microseconds frame_interval,
+    const UdpImpairment impairment) {
+  const size_t frame_length = frames.length() / frame_count;
+
+  std::atomic<bool> streaming = true;
+  std::atomic<bool> device_done = false;
+
+  TransportResult result{};
+  result.expected_samples = frame_count;
+
+  // the late and lost datagrams never become samples
+  for (size_t frame = 0; frame < frame_count; frame++) {
+    if ((impairment.lose && frame % 20 == 7) || (impairment.reorder && frame % 10 == 3 && frame + 1 < frame_count)) result.expected_samples--;
+  }
+
+  std::thread device_thread([&] {
+    // the device streams to wherever it last heard from
+    std::array<char, receive_buffer_length> request{};
+    sockaddr_in server{};
+    socklen_t server_length = sizeof server;
+    if (recvfrom(device_socket, request.data(), request.size(), 0, reinterpret_cast<sockaddr*>(&server), &server_length) < 0 ||
+        connect(device_socket, reinterpret_cast<sockaddr*>(&server), server_length) != 0) {
+      device_done = true;
+      return;
+    }
+
+    const auto send_frame = [&](const size_t frame) {
+      std::array<char, 128> datagram{};
+      WriteUdpHeader(static_cast<uint32_t>(frame), datagram.data());
+      std::copy_n(frames.data() + frame * frame_length, frame_length, datagram.data() + udp_header_length);
+      send(device_socket, datagram.data(), udp_header_length + frame_length, 0);
+    };
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frame_count; frame++) {
+      if (frame_interval.count() > 0) std::this_thread::sleep_until(begin + frame_interval * frame);
+
+      if (impairment.lose && frame % 20 == 7) continue;
+
+      if (impairment.reorder && frame % 10 == 3 && frame + 1 < frame_count) {
+        send_frame(frame + 1);
+        send_frame(frame);
+        frame++;
+        continue;
+      }
+
+      send_frame(frame);
+      if (impairment.duplicate && frame % 10 == 5) send_frame(frame);
+    }
+
+    device_done = true;
+  });
+
+  // the force feedback, and the device taking it off its socket
+  std::thread writer_thread([&] {
+    BinaryEncodingService encoding_service;
+    std::array<char, 64> output_buffer{};
+
+    for (int16_t i = 0; streaming; i++) {
+      const og::Output output = {.type = og::kOutputData_Type_ForceFeedback, .data = {.force_feedback_data = {i, i, i, i, i}}};
+      size_t output_length;
+      encoding_service.EncodePacket(output, output_buffer, output_length);
+
+      const auto write_begin = std::chrono::steady_clock::now();
+      if (!service.RawWrite(std::string_view(output_buffer.data(), output_length))) break;
+      result.write_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - write_begin).count());
+
+      std::this_thread::sleep_for(force_feedback_interval);
+    }
+  });
+
+  BinaryEncodingService encoding_service;
+  std::array<char, receive_buffer_length> buffer{};
+  std::array<og::Input, 64> inputs{};
+  std::array<og::DecodeStatus, 64> statuses{};
+
+  // datagrams can be lost, so the end is when the device has finished and nothing more arrives
+  const auto begin = std::chrono::steady_clock::now();
+  auto last_sample = begin;
+  for (bool finished = false; !finished;) {
+    const bool was_done = device_done;
+
+    size_t bytes_read;
+    if (!service.ReceiveNextChunk(buffer, bytes_read)) break;
+
+    for (std::string_view chunk(buffer.data(), bytes_read); !chunk.empty();) {
+      const DecodeChunkResult decoded = encoding_service.DecodeChunk(chunk, inputs, statuses);
+      chunk.remove_prefix(decoded.consumed);
+
+      for (size_t i = 0; i < decoded.emitted; i++) {
+        if (statuses[i] == og::kDecodeStatus_Ok) {
+          result.samples++;
+        } else {
+          result.decode_errors++;
+        }
+      }
+    }
+
+    if (bytes_read > 0) last_sample = std::chrono::steady_clock::now();
+    finished = was_done && bytes_read == 0;
+  }
+  result.seconds = std::chrono::duration<double>(last_sample - begin).count();
+
+  streaming = false;
+  writer_thread.join();
+  device_thread.join();
+
+  result.statistics = service.GetStatistics();
+
+  close(device_socket);
+
+  return result;
+}
+
+// a software source publishing to shared memory, with publish times in place of write times. Frames published faster than they are read are
+// overwritten, which are counted as dropped
+static TransportResult RunSharedMemory(const size_t frame_count, const std::chrono::microseconds frame_interval) {
+  TransportResult result{};
+
+  const std::string name = "opengloves_transport_bench_" + std::to_string(getpid());
+  std::unique_ptr<SharedMemoryInput> reader = SharedMemoryInput::Create(name);
+  std::unique_ptr<SharedMemoryInput> producer = SharedMemoryInput::Open(name);
+  if (reader == nullptr || producer == nullptr) return result;
+
+  std::atomic<bool> producer_done = false;
+  std::thread producer_thread([&] {
+    og::InputPeripheralData data{};
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frame_count; frame++) {
+      if (frame_interval.count() > 0) std::this_thread::sleep_until(begin + frame_interval * frame);
+
+      data.flexion[frame % 5][1] = static_cast<float>(frame % 64) / 64.0f;
+
+      const auto publish_begin = std::chrono::steady_clock::now();
+      producer->Publish(data);
+      result.write_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - publish_begin).count());
+    }
+
+    producer_done = true;
+  });
+
+  uint32_t read_sequence = reader->GetSequence();
+  uint64_t last_frame = 0;
+
+  const auto begin = std::chrono::steady_clock::now();
+  auto last_sample = begin;
+  for (;;) {
+    const bool was_done = producer_done;
+
+    // the frame was already there for the taking if the sequence moved on while the last was being handled, otherwise this waits on a futex
+    if (reader->GetSequence() == read_sequence) result.statistics.read_syscalls++;
+    if (!reader->WaitForPublish(read_sequence, std::chrono::milliseconds(250))) {
+      if (was_done) break;
+      continue;
+    }
+
+    SharedMemoryInputFrame frame;
+    if (!reader->Read(frame, read_sequence)) continue;
+
+    result.samples++;
+    result.statistics.dropped_packets += frame.frame - last_frame - 1;
+    last_frame = frame.frame;
+    last_sample = std::chrono::steady_clock::now();
+  }
+  result.seconds = std::chrono::duration<double>(last_sample - begin).count();
+
+  // the producer can fall behind its schedule and publish a few frames back to back, so some may be overwritten even when paced. Every frame must
+  // have been either read or counted as overwritten though, and the newest must have been read
+  result.expected_samples = last_frame == frame_count ? frame_count - result.statistics.dropped_packets : frame_count;
+
+  producer_thread.join();
+
+  shm_unlink(("/" + name).c_str());
+
+  return result;
+}
+
+static int ConnectIpcClient(const std::string& name) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::copy(name.begin(), name.end(), address.sun_path + 1);
+
+  const int client = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  if (connect(client, reinterpret_cast<sockaddr*>(&address), static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.length())) != 0) {
+    close(client);
+    return -1;
+  }
+
+  return client;
+}
+
+// a software source writing whole samples to an input pipe, which is a unix domain socket on linux. The read syscalls are the times the ipc event
+// loop woke up. If contended, another source floods a second pipe the whole time, which must not hold this one up
+static TransportResult RunIpc(const size_t frame_count, const std::chrono::microseconds frame_interval, const bool contended = false) {
+  TransportResult result{};
+  result.expected_samples = frame_count;
+
+  // the socket keeps the samples in order, so the nth handled is the nth sent
+  std::vector<std::atomic<int64_t>> sent_ns(frame_count);
+  std::atomic<double> max_delivery_us = 0;
+
+  std::atomic<size_t> samples = 0;
+  const std::string name = "opengloves/transport_bench/" + std::to_string(getpid());
+  IpcListener<og::InputPeripheralData> listener(name, [](const IpcListenerEvent&) {}, [&](uint64_t, const og::InputPeripheralData*) {
+    const size_t sample = samples.fetch_add(1, std::memory_order_relaxed);
+    if (sample >= frame_count) return;
+
+    const auto sent = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(sent_ns[sample].load(std::memory_order_relaxed)));
+    const double delivery_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count();
+    if (delivery_us > max_delivery_us.load(std::memory_order_relaxed)) max_delivery_us.store(delivery_us, std::memory_order_relaxed);
+  });
+
+  // each flooded sample takes as long to handle as it does to send, as the server's arbitration and hand off would, so the loop never catches up
+  const std::string flood_name = name + "/flood";
+  IpcListener<og::InputPeripheralData> flood_listener(flood_name, [](const IpcListenerEvent&) {}, [](uint64_t, const og::InputPeripheralData*) {
+    const auto busy_until = std::chrono::steady_clock::now() + std::chrono::microseconds(5);
+    while (std::chrono::steady_clock::now() < busy_until) {
+    }
+  });
+
+  const std::shared_ptr<IpcEventLoop> event_loop = IpcEventLoop::Acquire();
+  if (!listener.StartListening() || (contended && !flood_listener.StartListening())) return result;
+
+  const int client = ConnectIpcClient(name);
+  if (client < 0) return result;
+
+  std::atomic<bool> flooding = contended;
+  std::thread flood_thread([&] {
+    if (!flooding) return;
+
+    const int flood_client = ConnectIpcClient(flood_name);
+    const og::InputPeripheralData flood_data{};
+    while (flooding && send(flood_client, &flood_data, sizeof flood_data, MSG_NOSIGNAL) == sizeof flood_data) {
+    }
+
+    close(flood_client);
+  });
+
+  const uint64_t wakeups_before = event_loop->GetWakeups();
+
+  og::InputPeripheralData data{};
+  const auto begin = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < frame_count; frame++) {
+    if (frame_interval.count() > 0) std::this_thread::sleep_until(begin + frame_interval * frame);
+
+    data.flexion[frame % 5][1] = static_cast<float>(frame % 64) / 64.0f;
+
+    const auto write_begin = std::chrono::steady_clock::now();
+    sent_ns[frame].store(std::chrono::nanoseconds(write_begin.time_since_epoch()).count(), std::memory_order_relaxed);
+    if (send(client, &data, sizeof data, MSG_NOSIGNAL) != sizeof data) break;
+    result.write_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - write_begin).count());
+  }
+
+  // the socket is reliable, so everything sent arrives
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (samples.load(std::memory_order_relaxed) < frame_count && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  result.samples = samples.load(std::memory_order_relaxed);
+  result.statistics.read_syscalls = event_loop->GetWakeups() - wakeups_before;
+  result.max_delivery_us = max_delivery_us.load(std::memory_order_relaxed);
+
+  flooding = false;
+  flood_thread.join();
+  close(client);
+
+  return result;
+}
+
+// a serial device plugged in and taken out, as a symlink to a pseudo terminal outside of /dev, which the serial probers must be woken for with
+// one change each. A file next to it that isn't a configured port must not wake them
+static bool RunHotplug() {
+  // a change arrives once its events have settled, which is well within this
+  static constexpr auto hotplug_timeout = std::chrono::seconds(2);
+  // long enough for a change that shouldn't happen to have been seen if it did
+  static constexpr auto hotplug_quiet_time = std::chrono::milliseconds(500);
+
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    std::printf("hotplug: failed to open a pseudo terminal\n");
+    return false;
+  }
+
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("opengloves_hotplug_" + std::to_string(getpid()));
+  std::filesystem::create_directories(directory);
+  const std::filesystem::path port = directory / "ttyGLOVE";
+
+  bool ok = true;
+  {
+    HotplugWatcher watcher({port.string()});
+    if (!watcher.IsWatching()) {
+      std::printf("hotplug: not watching for devices\n");
+      ok = false;
+    }
+
+    // how long it took for each step to wake the waiter, and how many changes it saw
+    const auto step = [&](const char* name, const std::function<void()>& change, const uint64_t expected_changes) {
+      const uint64_t seen_changes = watcher.GetChanges();
+
+      const auto begin = std::chrono::steady_clock::now();
+      change();
+      const uint64_t changes = watcher.WaitForChange(seen_changes, expected_changes > 0 ? hotplug_timeout : hotplug_quiet_time) - seen_changes;
+      const double wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+      std::printf("%-20s %14.1f %14llu\n", name, wait_ms, static_cast<unsigned long long>(changes));
+      if (changes != expected_changes) {
+        std::printf(
+            "%s: saw %llu changes, expected %llu\n",
+            name,
+            static_cast<unsigned long long>(changes),
+            static_cast<unsigned long long>(expected_changes));
+        ok = false;
+      }
+    };
+
+    std::printf("\n%-20s %14s %14s\n", "hotplug", "wake ms", "changes");
+    step("unrelated_file", [&] { std::ofstream(directory / "unrelated"); }, 0);
+    step("plug_in", [&] { std::filesystem::create_symlink(ptsname(master), port); }, 1);
+    step("take_out", [&] { std::filesystem::remove(port); }, 1);
+  }
+
+  std::filesystem::remove_all(directory);
+  close(master);
+
+  return ok;
+}
+
+static double Percentile(std::vector<double> values, const double fraction) {
+  if (values.empty()) return 0;
+
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+}
+
+// require_all is false where the os may drop datagrams, ie. when flooding a udp socket faster than it is read
+static bool PrintResult(const char* name, const TransportResult& result, const bool require_all = true) {
+  // each read is a wait for data then the read itself, so a read that takes one sample at a time is two syscalls for it
+  const double syscalls_per_sample =
+      static_cast<double>(result.statistics.read_syscalls) / static_cast<double>(std::max<size_t>(result.samples, 1));
+
+  std::printf(
+      "%-20s %14.0f %14.2f %14.1f %14.1f %10zu %10llu\n",
+      name,
+      static_cast<double>(result.samples) / result.seconds,
+      syscalls_per_sample,
+      Percentile(result.write_us, 0.50),
+      Percentile(result.write_us, 0.99),
+      result.write_us.size(),
+      static_cast<unsigned long long>(result.statistics.dropped_packets));
+
+  if ((require_all && result.samples != result.expected_samples) || result.decode_errors != 0) {
+    std::printf(
+        "%s: received %zu of %zu samples, with %zu decode errors\n", name, result.samples, result.expected_samples, result.decode_errors);
+    return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  size_t frame_count = 200000;
+  if (argc > 1) frame_count = std::strtoull(argv[1], nullptr, 10);
+
+  // a hand moving slowly, sent as keyframes so that every frame is the same length on the wire
+  std::string frames;
+  og::InputPeripheralData peripheral{};
+  for (size_t i = 0; i < frame_count; i++) {
+    peripheral.flexion[i % 5][1] = static_cast<float>(i % 64) / 64.0f;
+    peripheral.trigger.value = static_cast<float>(i % 128) / 128.0f;
+
+    std::array<char, 64> frame_buffer{};
+    size_t frame_length;
+    const og::Input input = {.data = {.peripheral = peripheral}, .type = og::kInputDataType_Peripheral};
+    BinaryEncodingService::EncodeInput(input, static_cast<uint8_t>(i), frame_buffer, frame_length);
+    frames.append(frame_buffer.data(), frame_length);
+  }
+
+  // paced as a device would send them, to see the cost of a read when there is only a frame or two waiting
+  static constexpr size_t paced_frame_count = 2000;
+  static constexpr auto paced_frame_interval = std::chrono::microseconds(1000);
+  const std::string paced_frames = frames.substr(0, frames.length() / frame_count * paced_frame_count);
+
+  std::printf(
+      "%-20s %14s %14s %14s %14s %10s %10s\n", "transport", "samples/sec", "syscalls/sample", "write p50 us", "write p99 us", "writes", "dropped");
+
+  bool ok = true;
+  for (const bool paced : {false, true}) {
+    const size_t count = paced ? paced_frame_count : frame_count;
+    const std::string& stream = paced ? paced_frames : frames;
+    const auto interval = paced ? paced_frame_interval : std::chrono::microseconds(0);
+
+    {
+      std::array<int, 2> sockets{};
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()) != 0) {
+        std::printf("failed to create socketpair\n");
+        return 1;
+      }
+
+      SocketPairCommunicationService service(sockets[0]);
+      ok &= PrintResult(paced ? "socketpair_1khz" : "socketpair_flood", RunTransport(service, sockets[1], stream, count, interval));
+    }
+
+    {
+      const int listener = socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t address_length = sizeof address;
+      if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 || listen(listener, 1) != 0 ||
+          getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_length) != 0) {
+        std::printf("failed to listen on loopback\n");
+        return 1;
+      }
+
+      LoopbackCommunicationService service(ntohs(address.sin_port));
+      const int device_socket = accept(listener, nullptr, nullptr);
+      close(listener);
+
+      const int no_delay = 1;
+      setsockopt(device_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof no_delay);
+
+      ok &= PrintResult(paced ? "loopback_1khz" : "loopback_flood", RunTransport(service, device_socket, stream, count, interval));
+    }
+
+    {
+      // the serial service opens the slave end as it would a usb serial adapter
+      const int master = posix_openpt(O_RDWR | O_NOCTTY);
+      if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        std::printf("failed to open a pseudo terminal\n");
+        return 1;
+      }
+
+      SerialCommunicationService service({.port_name = ptsname(master), .baud_rate = 115200});
+      if (!service.IsConnected()) {
+        std::printf("failed to connect to pseudo terminal\n");
+        return 1;
+      }
+
+      ok &= PrintResult(paced ? "pty_1khz" : "pty_flood", RunTransport(service, master, stream, count, interval));
+    }
+  }
+
+  // the device's socket, which it also announces itself from
+  const auto open_udp_device = [](uint16_t& out_port) {
+    const int device_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof address;
+    bind(device_socket, reinterpret_cast<sockaddr*>(&address), sizeof address);
+    getsockname(device_socket, reinterpret_cast<sockaddr*>(&address), &address_length);
+
+    out_port = ntohs(address.sin_port);
+    return device_socket;
+  };
+
+  // found by its announcement, as on a real network
+  {
+    uint16_t device_port;
+    const int device_socket = open_udp_device(device_port);
+
+    std::atomic<bool> announcing = true;
+    std::thread announce_thread([&] {
+      const std::string announcement = std::string(udp_announcement_prefix) + "transport-bench";
+
+      sockaddr_in discovery{};
+      discovery.sin_family = AF_INET;
+      discovery.sin_port = htons(udp_discovery_port);
+      discovery.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      while (announcing) {
+        sendto(device_socket, announcement.data(), announcement.length(), 0, reinterpret_cast<sockaddr*>(&discovery), sizeof discovery);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+    });
+
+    std::vector<std::unique_ptr<ICommunicationService>> found;
+    UdpAnnouncementProber prober({.name = "transport-bench", .address = "", .port = 0});
+    const bool announced = prober.InquireDevices(found);
+
+    announcing = false;
+    announce_thread.join();
+
+    if (!announced || found.size() != 1 || prober.InquireDevices(found)) {
+      std::printf("udp device was not found once from its announcement\n");
+      return 1;
+    }
+
+    ok &= PrintResult("udp_flood", RunUdpTransport(*found[0], device_socket, frames, frame_count, std::chrono::microseconds(0), {}), false);
+  }
+
+  static constexpr size_t udp_frame_count = 5000;
+  static constexpr auto udp_frame_interval = std::chrono::microseconds(100);
+  const std::string udp_frames = frames.substr(0, frames.length() / frame_count * udp_frame_count);
+
+  const std::vector<std::pair<const char*, UdpImpairment>> udp_impairments = {
+      {"udp_10khz", {}},
+      {"udp_lossy_10khz", {.lose = true, .reorder = false, .duplicate = false}},
+      {"udp_reorder_10khz", {.lose = false, .reorder = true, .duplicate = true}},
+  };
+  for (const auto& [name, impairment] : udp_impairments) {
+    uint16_t device_port;
+    const int device_socket = open_udp_device(device_port);
+
+    UdpCommunicationService service({.name = name, .address = "127.0.0.1", .port = device_port});
+    const TransportResult result = RunUdpTransport(service, device_socket, udp_frames, udp_frame_count, udp_frame_interval, impairment);
+    ok &= PrintResult(name, result);
+
+    // the late and duplicate datagrams are the ones dropped
+    const size_t expected_dropped = impairment.reorder ? udp_frame_count / 10 * 2 : 0;
+    if (result.statistics.dropped_packets != expected_dropped) {
+      std::printf(
+          "%s: dropped %llu datagrams, expected %zu\n", name, static_cast<unsigned long long>(result.statistics.dropped_packets), expected_dropped);
+      ok = false;
+    }
+  }
+
+  ok &= PrintResult("ipc_flood", RunIpc(frame_count, std::chrono::microseconds(0)));
+  ok &= PrintResult("ipc_1khz", RunIpc(paced_frame_count, paced_frame_interval));
+  // a pipe being flooded must not hold up another for more than a few of its messages. The loop emptying a client before moving on held the paced
+  // pipe up for tens of milliseconds
+  static constexpr double ipc_contended_max_delivery_us = 10000;
+  const TransportResult ipc_contended = RunIpc(paced_frame_count, paced_frame_interval, true);
+  ok &= PrintResult("ipc_1khz_contended", ipc_contended);
+  if (ipc_contended.max_delivery_us > ipc_contended_max_delivery_us) {
+    std::printf(
+        "ipc_1khz_contended: a sample took %.0fus to be handled, expected at most %.0fus\n",
+        ipc_contended.max_delivery_us,
+        ipc_contended_max_delivery_us);
+    ok = false;
+  }
+
+  ok &= PrintResult("shm_flood", RunSharedMemory(frame_count, std::chrono::microseconds(0)));
+  ok &= PrintResult("shm_1khz", RunSharedMemory(paced_frame_count, paced_frame_interval));
+
+  ok &= RunHotplug();
+
+  return ok ? 0 : 1;
+}
@@ -7,9 +7,13 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <variant>
 
@@ -17,8 +21,8 @@ namespace og {
 
   enum Hand { kHandLeft, kHandRight };
 
-  enum EncodingType { kEncodingType_Alpha };
-  enum CommunicationType { kCommunicationType_Serial, kCommunicationType_Bluetooth, kCommunicationType_Invalid };
+  enum EncodingType { kEncodingType_Alpha, kEncodingType_Binary };
+  enum CommunicationType { kCommunicationType_Serial, kCommunicationType_Bluetooth, kCommunicationType_Udp, kCommunicationType_Invalid };
 
   enum DeviceType {
     kDeviceType_lucidgloves,
@@ -32,14 +36,22 @@ namespace og {
     std::string name;  // must be set if auto probe is disabled
   };
   struct DeviceSerialCommunicationConfiguration {
-    std::string port_name;  // must be set if auto probe is disabled
+    std::string port_name;   // must be set if auto probe is disabled
+    unsigned int baud_rate;  // 0 to detect the rate the device is sending at
+  };
+  struct DeviceUdpCommunicationConfiguration {
+    std::string name;     // the name the device announces itself with, must be set if auto probe is disabled
+    std::string address;  // ipv4 address of the device. If empty, it (and the port) are found from the device's announcement
+    uint16_t port;
   };
 
   struct DeviceCommunicationConfiguration {
     DeviceSerialCommunicationConfiguration serial;
     DeviceBluetoothCommunicationConfiguration bluetooth;
+    DeviceUdpCommunicationConfiguration udp;
 
-    DeviceAlphaEncodingConfiguration encoding;
+    EncodingType encoding_type;
+    DeviceAlphaEncodingConfiguration encoding;  // only used by the alpha encoding
   };
 
   struct DeviceConfiguration {
@@ -56,8 +68,22 @@ namespace og {
   struct SerialCommunicationConfiguration {
     bool enabled;
   };
+  struct UdpCommunicationConfiguration {
+    bool enabled;
+  };
+  // which of the clients writing to a hand's pipes at once is forwarded
+  enum NamedPipeArbitration {
+    kNamedPipeArbitration_LastWriter,  // every sample, from whichever client sent it
+    kNamedPipeArbitration_Priority,    // only the client that connected first, until it goes quiet or away
+    kNamedPipeArbitration_Freshest,    // only samples newer than the last one forwarded, from any client
+  };
+
   struct NamedPipeCommunicationConfiguration {
     bool enabled;
+    NamedPipeArbitration arbitration;
+  };
+  struct SharedMemoryCommunicationConfiguration {
+    bool enabled;
   };
 
   struct CommunicationConfiguration {
@@ -65,7 +91,9 @@ namespace og {
 
     SerialCommunicationConfiguration serial;
     BluetoothCommunicationConfiguration bluetooth;
+    UdpCommunicationConfiguration udp;
     NamedPipeCommunicationConfiguration named_pipe;
+    SharedMemoryCommunicationConfiguration shared_memory;
   };
 
   struct ServerConfiguration {
@@ -119,6 +147,10 @@ namespace og {
     DeviceType device_type;
 
     int firmware_version;
+
+    // capabilities, zero if the firmware does not report them
+    uint32_t supported_encodings;  // bitfield of (1 << EncodingType)
+    int max_analog_resolution;     // in bits
   };
 
   union InputData {
@@ -134,6 +166,26 @@ namespace og {
     InputDataType type;
   };
 
+  // result of decoding a packet from a device. Whether the packet was dropped is given by the input type (kInputDataType_Invalid), as some statuses
+  // are only informational for some encodings (ie. an unknown key is skipped in an alpha packet, but an unknown frame type is dropped)
+  enum DecodeStatus {
+    kDecodeStatus_Ok,
+    kDecodeStatus_Empty,             // the packet did not contain any data
+    kDecodeStatus_UnknownKey,        // the packet contained a key or frame type that the encoding does not know about
+    kDecodeStatus_MissingValue,      // a key that needs a value did not have one
+    kDecodeStatus_NumberOverflow,    // a value was too large to represent
+    kDecodeStatus_Truncated,         // the packet was cut off, or was shorter than its type needs
+    kDecodeStatus_ChecksumMismatch,  // the packet was corrupted in transit
+    kDecodeStatus_Malformed,         // the packet could not be split from the stream (ie. bad framing)
+    kDecodeStatus_Desynchronised,    // the packet only held changes, and the values they apply to were lost
+    kDecodeStatus_Max
+  };
+
+  struct DeviceDecodeStatistics {
+    // number of packets decoded with each status
+    std::array<uint64_t, kDecodeStatus_Max> packets;
+  };
+
   // force feedback output data from server to device
   struct OutputForceFeedbackData {
     int16_t thumb;
@@ -152,13 +204,27 @@ namespace og {
     bool start_streaming;
     bool get_info;
   };
+  // the encoding and analog resolution the device should stream with, agreed from its info. Takes effect after this output
+  struct OutputConfigureData {
+    EncodingType encoding;
+    int analog_resolution;  // in bits, 0 to leave it unchanged
+  };
 
   union OutputData {
     OutputFetchInfoData fetch_info;
     OutputHapticData haptic_data;
     OutputForceFeedbackData force_feedback_data;
+    OutputConfigureData configure;
+  };
+  enum OutputDataType {
+    kOutputDataType_Empty,
+    kOutputDataType_FetchInfo,
+    kOutputDataType_Haptic,
+    kOutputData_Type_ForceFeedback,
+    kOutputDataType_Configure,
+    kOutputDataType_RequestKeyframe,  // ask the device for a full set of values, after a lost packet
+    kOutputDataType_Max
   };
-  enum OutputDataType { kOutputDataType_Empty, kOutputDataType_FetchInfo, kOutputDataType_Haptic, kOutputData_Type_ForceFeedback };
 
   // output data from driver to glove
   struct Output {
@@ -166,14 +232,101 @@ namespace og {
     OutputData data;
   };
 
+  struct DeviceOutputStatistics {
+    uint64_t queued;      // waiting to be written
+    uint64_t written;
+    uint64_t superseded;  // replaced by a newer output of the same type before they were written
+    uint64_t expired;     // waited past the deadline for their type, so were not worth writing any more
+    uint64_t dropped;     // too many outputs were already waiting, or they could not be encoded
+  };
+
+  struct DeviceWriteStatistics {
+    std::array<DeviceOutputStatistics, kOutputDataType_Max> outputs;  // by OutputDataType
+
+    // time from an output being queued to the write with it returning, in nanoseconds
+    uint64_t last_latency_ns;
+    uint64_t max_latency_ns;
+    uint64_t total_latency_ns;  // over every output written, for the mean
+  };
+
+  struct DeviceInputStatistics {
+    uint64_t delivered;    // samples passed to the input callback
+    uint64_t overwritten;  // replaced by a newer sample before the input callback was ready for them
+  };
+
+  // bucket n of the gap (and latency) histogram counts gaps of 2^n to 2^(n + 1) microseconds. The first also counts shorter gaps and the last
+  // longer ones
+  static constexpr size_t link_gap_histogram_buckets = 24;
+
+  struct DeviceLinkStatistics {
+    uint64_t samples;           // inputs received from the device
+    double samples_per_second;  // over the last whole second, zero if the device has gone quiet
+
+    // time between samples arriving
+    std::array<uint64_t, link_gap_histogram_buckets> gap_histogram;
+    uint64_t gap_p50_us;  // estimated from the histogram
+    uint64_t gap_p99_us;
+
+    // time from the device taking a sample to it arriving, only for transports whose samples say when they were taken (zero for the rest)
+    std::array<uint64_t, link_gap_histogram_buckets> latency_histogram;
+    uint64_t latency_p50_us;
+    uint64_t latency_p99_us;
+
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+
+    // calls into the os by the transport, over samples for what each sample costs
+    uint64_t read_syscalls;
+    uint64_t write_syscalls;
+
+    uint64_t dropped_packets;  // discarded by the transport before being decoded, ie. datagrams that arrived late or twice
+    uint64_t lost_samples;     // numbered by the device but never arrived, only for transports whose samples are numbered
+
+    uint64_t decode_errors;  // packets that decoded with any status other than ok
+    uint64_t write_failures;
+    uint64_t reconnects;
+
+    // for transports that several clients can write to at once (ie. named pipes), zero for the rest
+    uint64_t clients;  // connected now
+    uint64_t client_connects;
+    uint64_t client_disconnects;
+  };
+
+  struct DeviceStatistics {
+    DeviceDecodeStatistics decode;
+    DeviceWriteStatistics write;
+    DeviceInputStatistics input;
+    DeviceLinkStatistics link;
+  };
+
+  enum DeviceConnectionState {
+    kDeviceConnectionState_Connected,
+    kDeviceConnectionState_Disconnected,  // the link to the device was lost, it is being reconnected
+  };
+
   class IDevice {
    public:
     virtual DeviceConfiguration GetConfiguration() = 0;
 
+    /***
+     * callback is called from the device's communication thread when the link to the device is lost, and again once it has reconnected. Devices
+     * start out connected. Must be called before ListenForInput.
+     */
+    virtual void ListenForConnectionState(std::function<void(DeviceConnectionState state)> callback) = 0;
+
+    /***
+     * callback is called from a thread of the device's own with the latest input. If it is still busy with one input when more arrive, it is only
+     * called again with the newest of them.
+     */
     virtual void ListenForInput(std::function<void(const InputPeripheralData& data)> callback) = 0;
 
     virtual void Output(const Output& output) = 0;
 
+    /***
+     * Counters about the connection to the device. Safe to call from any thread.
+     */
+    virtual DeviceStatistics GetStatistics() = 0;
+
     virtual ~IDevice() = default;
   };
 
@@ -208,6 +361,9 @@ namespace og {
 
   enum LoggerLevel { kLoggerLevel_Info, kLoggerLevel_Warning, kLoggerLevel_Error };
 
+  // how often a message that could be logged for every sample or write is logged at most
+  static constexpr int64_t log_rate_limit_ms = 1000;
+
   class Logger {
    public:
     static Logger& GetInstance() {
@@ -217,12 +373,31 @@ namespace og {
     };
 
     void SubscribeToLogger(std::function<void(const std::string& message, LoggerLevel level)> callback) {
+      std::scoped_lock lock(mutex_);
+
       callbacks_.emplace_back(callback);
     }
 
     template <typename... Args>
     void Log(LoggerLevel level, const char* format, Args... args) {
-      const std::string message = StringFormat(format, args...);
+      Publish(level, StringFormat(format, args...));
+    }
+
+    // for OG_LOG_EVERY_N and OG_LOG_EVERY_MS, which say how many times the message was held back since it was last logged
+    template <typename... Args>
+    void LogRateLimited(LoggerLevel level, const uint64_t suppressed, const char* format, Args... args) {
+      std::string message = StringFormat(format, args...);
+      if (suppressed > 0) message += " (" + std::to_string(suppressed) + " more since last logged)";
+
+      Publish(level, message);
+    }
+
+   private:
+    Logger() = default;
+
+    void Publish(const LoggerLevel level, const std::string& message) {
+      // logged from every device's threads
+      std::scoped_lock lock(mutex_);
 
       if (last_message_ == message) return;
       last_message_ = message;
@@ -232,15 +407,12 @@ namespace og {
       }
     }
 
-   private:
-    Logger() = default;
-    ;
-
    public:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
    private:
+    std::mutex mutex_;
     std::vector<std::function<void(const std::string& message, LoggerLevel level)>> callbacks_;
 
     std::string last_message_;
@@ -257,4 +429,72 @@ namespace og {
       return {buf.get(), buf.get() + size - 1};
     }
   };
-}  // namespace og
\ No newline at end of file
+
+  /**
+   * Holds back a message that could otherwise be logged for every sample or write (ie. a decode or write failure), so that a failing link
+   * doesn't flood the log. OG_LOG_EVERY_N and OG_LOG_EVERY_MS declare one for the place that logs, which is shared by every object logging from
+   * there. Messages about one device should use one kept by that device instead (with OG_LOG_EVERY_MS_WITH), so that one failing device doesn't
+   * hold back another's.
+   *
+   * Holding a message back costs an atomic add every n, and a read of the clock and an atomic add every interval. Nothing is formatted until it
+   * is let through.
+   */
+  class LogRateLimiter {
+   public:
+    // lets through the first occurrence and every nth after it
+    bool ShouldLogEveryN(const uint64_t n, uint64_t& out_suppressed) {
+      const uint64_t occurrence = occurrences_.fetch_add(1, std::memory_order_relaxed);
+      if (n > 1 && occurrence % n != 0) return false;
+
+      out_suppressed = occurrence == 0 ? 0 : n - 1;
+      return true;
+    }
+
+    // lets through the first occurrence, then at most one every interval
+    bool ShouldLogEveryMs(const int64_t interval_ms, uint64_t& out_suppressed) {
+      const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+      // only the occurrence that moves the next time on is let through, another thread may get here at the same time
+      int64_t next_ns = next_ns_.load(std::memory_order_relaxed);
+      if (now_ns < next_ns || !next_ns_.compare_exchange_strong(next_ns, now_ns + interval_ms * 1'000'000, std::memory_order_relaxed)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+
+      out_suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+      return true;
+    }
+
+   private:
+    std::atomic<uint64_t> occurrences_ = 0;
+
+    std::atomic<int64_t> next_ns_ = 0;
+    std::atomic<uint64_t> suppressed_ = 0;
+  };
+}  // namespace og
+
+// logs the first time this line is reached and every nth time after that
+#define OG_LOG_EVERY_N(n, level, ...)                                                  \
+  do {                                                                                 \
+    static og::LogRateLimiter og_log_rate_limiter;                                     \
+    uint64_t og_log_suppressed = 0;                                                    \
+    if (og_log_rate_limiter.ShouldLogEveryN(n, og_log_suppressed)) {                   \
+      og::Logger::GetInstance().LogRateLimited(level, og_log_suppressed, __VA_ARGS__); \
+    }                                                                                  \
+  } while (0)
+
+// as OG_LOG_EVERY_MS, but held back by limiter (an og::LogRateLimiter, ie. one for each device) rather than one for the line
+#define OG_LOG_EVERY_MS_WITH(limiter, interval_ms, level, ...)                         \
+  do {                                                                                 \
+    uint64_t og_log_suppressed = 0;                                                    \
+    if ((limiter).ShouldLogEveryMs(interval_ms, og_log_suppressed)) {                  \
+      og::Logger::GetInstance().LogRateLimited(level, og_log_suppressed, __VA_ARGS__); \
+    }                                                                                  \
+  } while (0)
+
+// logs the first time this line is reached, then at most once every interval_ms. The limit is shared by every object that logs from the line
+#define OG_LOG_EVERY_MS(interval_ms, level, ...)                                \
+  do {                                                                          \
+    static og::LogRateLimiter og_log_rate_limiter;                              \
+    OG_LOG_EVERY_MS_WITH(og_log_rate_limiter, interval_ms, level, __VA_ARGS__); \
+  } while (0)
@@ -0,0 +1,24 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "ipc_event_loop.h"
+
+#include <mutex>
+
+std::shared_ptr<IpcEventLoop> IpcEventLoop::Acquire() {
+  static std::mutex mutex;
+  static std::weak_ptr<IpcEventLoop> instance;
+
+  std::scoped_lock lock(mutex);
+
+  std::shared_ptr<IpcEventLoop> result = instance.lock();
+  if (result == nullptr) {
+    result = std::shared_ptr<IpcEventLoop>(new IpcEventLoop());
+    instance = result;
+  }
+
+  return result;
+}
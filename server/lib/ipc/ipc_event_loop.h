@@ -0,0 +1,66 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+
+enum class IpcListenerEventType { Invalid, ClientConnected, ClientDisconnected };
+
+struct IpcListenerEvent {
+  IpcListenerEventType type;
+  uint64_t client;  // never reused while the loop runs, across every endpoint
+};
+
+// clients beyond this on one endpoint are turned away (or left waiting, on windows) until another goes away
+static constexpr size_t ipc_max_clients = 8;
+
+/**
+ * The one thread that services every ipc endpoint (ie. the input and force feedback pipes for both hands). It waits on an io completion port on
+ * windows and on epoll on linux, so only wakes when a client connects, sends something or goes away, or when an endpoint is added or removed, and
+ * never on a timer.
+ *
+ * An endpoint called "a/b/c" is the named pipe \\.\pipe\a\b\c on windows, and the unix domain socket @a/b/c (in the abstract namespace) on linux.
+ * Both are message based, so each message a client writes arrives whole in one callback. An endpoint serves up to ipc_max_clients at once (a pipe
+ * instance each on windows), and every callback says which client it is for.
+ */
+class IpcEventLoop {
+ public:
+  // the loop that every endpoint shares, which runs for as long as anything holds it
+  static std::shared_ptr<IpcEventLoop> Acquire();
+
+  /**
+   * Callbacks are called from the loop's thread, one at a time across every endpoint. A message longer than max_message_length, or one that
+   * on_message returns false for, disconnects the client that sent it. Every client that connects is reported disconnected once it goes away,
+   * unless the endpoint is removed first. Returns zero if the endpoint could not be created.
+   *
+   * The message on_message is given starts on a boundary suitable for any type (alignof(std::max_align_t)), so can be read in place. It is only
+   * valid until on_message returns.
+   */
+  uint64_t AddEndpoint(
+      const std::string& name,
+      size_t max_message_length,
+      std::function<void(const IpcListenerEvent& event)> on_event,
+      std::function<bool(uint64_t client, std::span<const char> message)> on_message);
+
+  // once this returns, the endpoint's callbacks are never called again. Must not be called from one of them
+  void RemoveEndpoint(uint64_t endpoint);
+
+  // times the loop's thread has woken up, for what each message costs
+  uint64_t GetWakeups();
+
+  ~IpcEventLoop();
+
+ private:
+  IpcEventLoop();
+
+  class Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
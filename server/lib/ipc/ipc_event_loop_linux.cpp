@@ -0,0 +1,323 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ipc_event_loop.h"
+#include "opengloves_interface.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+// epoll events carry the id of an endpoint or a client shifted up by one, with the bottom bit set for a client
+static constexpr uint64_t wake_event_data = 0;
+
+// the most messages taken from one client each time the loop wakes. A client that writes as fast as it is read (ie. a tracker at 1kHz or more)
+// would otherwise keep every other endpoint waiting. Epoll is level triggered, so reports the client again for the rest
+static constexpr int ipc_max_messages_per_wakeup = 16;
+
+static uint64_t EndpointEventData(const uint64_t endpoint) {
+  return endpoint << 1;
+}
+
+static uint64_t ClientEventData(const uint64_t client) {
+  return client << 1 | 1;
+}
+
+struct IpcEndpoint {
+  uint64_t id;
+  std::string name;
+
+  int listen_fd = -1;
+  size_t clients = 0;
+
+  std::function<void(const IpcListenerEvent& event)> on_event;
+  std::function<bool(uint64_t client, std::span<const char> message)> on_message;
+
+  // one byte more than the longest message, so that a longer one shows as such rather than being cut short. Shared by its clients, as only one
+  // is read from at a time
+  std::vector<char> buffer;
+};
+
+struct IpcClient {
+  uint64_t id;
+  uint64_t endpoint;
+  int fd;
+};
+
+class IpcEventLoop::Impl {
+ public:
+  Impl() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    epoll_event wake_event{.events = EPOLLIN, .data = {.u64 = wake_event_data}};
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake_event) != 0) {
+      LogError("Failed to create ipc event loop", "");
+      return;
+    }
+
+    thread_active_ = true;
+    thread_ = std::thread(&IpcEventLoop::Impl::LoopThread, this);
+  }
+
+  uint64_t AddEndpoint(
+      const std::string& name,
+      const size_t max_message_length,
+      std::function<void(const IpcListenerEvent& event)> on_event,
+      std::function<bool(uint64_t client, std::span<const char> message)> on_message) {
+    if (!thread_active_) return 0;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (name.length() + 1 > sizeof address.sun_path) {
+      logger.Log(og::kLoggerLevel_Error, "Ipc endpoint name is too long: %s", name.c_str());
+      return 0;
+    }
+
+    // the abstract namespace, so there is no socket file to be left behind
+    std::memcpy(address.sun_path + 1, name.data(), name.length());
+    const auto address_length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.length());
+
+    const int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+      LogError("Failed to create ipc endpoint", name);
+      return 0;
+    }
+
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), address_length) != 0 || listen(listen_fd, ipc_max_clients) != 0) {
+      LogError("Failed to listen on ipc endpoint", name);
+      close(listen_fd);
+      return 0;
+    }
+
+    std::scoped_lock lock(mutex_);
+
+    const uint64_t id = next_endpoint_++;
+    IpcEndpoint& endpoint = endpoints_[id];
+    endpoint.id = id;
+    endpoint.name = name;
+    endpoint.listen_fd = listen_fd;
+    endpoint.on_event = std::move(on_event);
+    endpoint.on_message = std::move(on_message);
+    endpoint.buffer.resize(max_message_length + 1);
+
+    epoll_event listen_event{.events = EPOLLIN, .data = {.u64 = EndpointEventData(id)}};
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd, &listen_event) != 0) {
+      LogError("Failed to watch ipc endpoint", name);
+      close(listen_fd);
+      endpoints_.erase(id);
+      return 0;
+    }
+
+    return id;
+  }
+
+  void RemoveEndpoint(const uint64_t id) {
+    // waits for a callback in progress to finish
+    std::scoped_lock lock(mutex_);
+
+    const auto it = endpoints_.find(id);
+    if (it == endpoints_.end()) return;
+
+    // closing them also takes them out of the epoll set
+    std::erase_if(clients_, [&](const auto& client) {
+      if (client.second.endpoint != id) return false;
+
+      close(client.second.fd);
+      return true;
+    });
+    close(it->second.listen_fd);
+
+    endpoints_.erase(it);
+  }
+
+  uint64_t GetWakeups() const {
+    return wakeups_.load(std::memory_order_relaxed);
+  }
+
+  ~Impl() {
+    if (thread_active_.exchange(false)) {
+      const uint64_t wake = 1;
+      if (write(wake_fd_, &wake, sizeof wake) != sizeof wake) LogError("Failed to wake ipc event loop", "");
+
+      thread_.join();
+    }
+
+    for (auto& [id, client] : clients_) close(client.fd);
+    for (auto& [id, endpoint] : endpoints_) close(endpoint.listen_fd);
+
+    if (wake_fd_ >= 0) close(wake_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+  }
+
+ private:
+  void LoopThread() {
+    std::array<epoll_event, 16> events{};
+
+    while (thread_active_) {
+      const int ready = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+      wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+      if (ready < 0) {
+        if (errno == EINTR) continue;
+
+        LogError("Failed waiting for ipc events", "");
+        return;
+      }
+
+      std::scoped_lock lock(mutex_);
+
+      for (int i = 0; i < ready; i++) {
+        const uint64_t data = events[i].data.u64;
+        if (data == wake_event_data) continue;
+
+        // either may have been removed by an earlier event in this batch, or since the wait returned
+        if (data & 1) {
+          const auto client = clients_.find(data >> 1);
+          if (client != clients_.end()) OnClientReady(client->second, events[i].events);
+        } else {
+          const auto endpoint = endpoints_.find(data >> 1);
+          if (endpoint != endpoints_.end()) OnEndpointReady(endpoint->second);
+        }
+      }
+    }
+  }
+
+  void OnEndpointReady(IpcEndpoint& endpoint) {
+    for (;;) {
+      const int client_fd = accept4(endpoint.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (client_fd < 0) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) LogError("Failed to accept ipc client", endpoint.name);
+        return;
+      }
+
+      if (endpoint.clients >= ipc_max_clients) {
+        OG_LOG_EVERY_MS(
+            og::log_rate_limit_ms, og::kLoggerLevel_Warning, "Turned away ipc client as %s already has %zu", endpoint.name.c_str(), endpoint.clients);
+        close(client_fd);
+        continue;
+      }
+
+      const uint64_t id = next_client_++;
+      epoll_event client_event{.events = EPOLLIN, .data = {.u64 = ClientEventData(id)}};
+      if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &client_event) != 0) {
+        LogError("Failed to watch ipc client", endpoint.name);
+        close(client_fd);
+        continue;
+      }
+
+      clients_[id] = {.id = id, .endpoint = endpoint.id, .fd = client_fd};
+      endpoint.clients++;
+
+      endpoint.on_event({.type = IpcListenerEventType::ClientConnected, .client = id});
+    }
+  }
+
+  void OnClientReady(IpcClient& client, const uint32_t events) {
+    IpcEndpoint& endpoint = endpoints_.at(client.endpoint);
+
+    for (int message = 0; message < ipc_max_messages_per_wakeup; message++) {
+      const ssize_t length = recv(client.fd, endpoint.buffer.data(), endpoint.buffer.size(), MSG_DONTWAIT);
+
+      if (length < 0) {
+        if (errno == EINTR) continue;
+
+        // everything the client sent has been taken, so it going away can be handled now
+        if (errno == EAGAIN) {
+          if (events & (EPOLLHUP | EPOLLERR)) DisconnectClient(endpoint, client);
+          return;
+        }
+
+        LogError("Failed to read from ipc client", endpoint.name);
+        DisconnectClient(endpoint, client);
+        return;
+      }
+
+      // the client went away
+      if (length == 0) {
+        DisconnectClient(endpoint, client);
+        return;
+      }
+
+      if (static_cast<size_t>(length) == endpoint.buffer.size()) {
+        OG_LOG_EVERY_MS(og::log_rate_limit_ms, og::kLoggerLevel_Error, "Ipc client sent a message that was too long (%s)", endpoint.name.c_str());
+        DisconnectClient(endpoint, client);
+        return;
+      }
+
+      if (!endpoint.on_message(client.id, std::span<const char>(endpoint.buffer.data(), static_cast<size_t>(length)))) {
+        DisconnectClient(endpoint, client);
+        return;
+      }
+    }
+  }
+
+  // client is gone once this returns
+  void DisconnectClient(IpcEndpoint& endpoint, const IpcClient& client) {
+    const uint64_t id = client.id;
+
+    close(client.fd);
+    clients_.erase(id);
+    endpoint.clients--;
+
+    endpoint.on_event({.type = IpcListenerEventType::ClientDisconnected, .client = id});
+  }
+
+  static void LogError(const char* message, const std::string& name) {
+    logger.Log(og::kLoggerLevel_Error, "%s (%s): %s", message, name.c_str(), std::strerror(errno));
+  }
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+
+  // held while handling events, so that an endpoint can't be removed from under its callbacks
+  std::mutex mutex_;
+  std::map<uint64_t, IpcEndpoint> endpoints_;
+  std::map<uint64_t, IpcClient> clients_;
+  uint64_t next_endpoint_ = 1;
+  uint64_t next_client_ = 1;
+
+  std::atomic<bool> thread_active_ = false;
+  std::thread thread_;
+
+  std::atomic<uint64_t> wakeups_ = 0;
+};
+
+IpcEventLoop::IpcEventLoop() : pImpl_(std::make_unique<Impl>()) {}
+
+uint64_t IpcEventLoop::AddEndpoint(
+    const std::string& name,
+    const size_t max_message_length,
+    std::function<void(const IpcListenerEvent& event)> on_event,
+    std::function<bool(uint64_t client, std::span<const char> message)> on_message) {
+  return pImpl_->AddEndpoint(name, max_message_length, std::move(on_event), std::move(on_message));
+}
+
+void IpcEventLoop::RemoveEndpoint(const uint64_t endpoint) {
+  pImpl_->RemoveEndpoint(endpoint);
+}
+
+uint64_t IpcEventLoop::GetWakeups() {
+  return pImpl_->GetWakeups();
+}
+
+IpcEventLoop::~IpcEventLoop() = default;
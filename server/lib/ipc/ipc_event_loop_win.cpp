@@ -0,0 +1,390 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ipc_event_loop.h"
+#include "opengloves_interface.h"
+#include "win/win_util.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+enum class IpcPipeInstanceState { Connecting, Reading };
+
+struct IpcEndpoint;
+
+// one instance of an endpoint's pipe, which serves one client at a time
+struct IpcPipeInstance {
+  // first, so that the OVERLAPPED a completion hands back is the instance
+  OVERLAPPED overlapped;
+
+  IpcEndpoint* endpoint = nullptr;
+  HANDLE pipe = INVALID_HANDLE_VALUE;
+
+  IpcPipeInstanceState state = IpcPipeInstanceState::Connecting;
+  uint64_t client = 0;  // zero while no client is connected
+
+  // an operation is queued with the pipe, and the instance must outlive it
+  bool pending = false;
+  bool closing = false;
+
+  std::vector<char> buffer;
+};
+
+struct IpcEndpoint {
+  std::string name;
+  size_t max_message_length;
+
+  std::function<void(const IpcListenerEvent& event)> on_event;
+  std::function<bool(uint64_t client, std::span<const char> message)> on_message;
+
+  // every instance that is either connected to a client or waiting for one. There is always exactly one waiting, unless ipc_max_clients are
+  // connected
+  std::vector<std::unique_ptr<IpcPipeInstance>> instances;
+};
+
+class IpcEventLoop::Impl {
+ public:
+  Impl() {
+    port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (port_ == nullptr) {
+      LogError("Failed to create ipc event loop", "");
+      return;
+    }
+
+    thread_active_ = true;
+    thread_ = std::thread(&IpcEventLoop::Impl::LoopThread, this);
+  }
+
+  uint64_t AddEndpoint(
+      const std::string& name,
+      const size_t max_message_length,
+      std::function<void(const IpcListenerEvent& event)> on_event,
+      std::function<bool(uint64_t client, std::span<const char> message)> on_message) {
+    if (!thread_active_) return 0;
+
+    std::string pipe_name = R"(\\.\pipe\)" + name;
+    std::replace(pipe_name.begin(), pipe_name.end(), '/', '\\');
+
+    auto endpoint = std::make_unique<IpcEndpoint>();
+    endpoint->name = pipe_name;
+    endpoint->max_message_length = max_message_length;
+    endpoint->on_event = std::move(on_event);
+    endpoint->on_message = std::move(on_message);
+
+    std::scoped_lock lock(mutex_);
+
+    if (!AddInstance(*endpoint)) return 0;
+
+    const uint64_t id = next_endpoint_++;
+    endpoints_.emplace(id, std::move(endpoint));
+
+    return id;
+  }
+
+  void RemoveEndpoint(const uint64_t id) {
+    // waits for a callback in progress to finish
+    std::scoped_lock lock(mutex_);
+
+    const auto it = endpoints_.find(id);
+    if (it == endpoints_.end()) return;
+
+    std::unique_ptr<IpcEndpoint> endpoint = std::move(it->second);
+    endpoints_.erase(it);
+
+    for (auto& instance : endpoint->instances) CloseInstance(std::move(instance));
+  }
+
+  uint64_t GetWakeups() const {
+    return wakeups_.load(std::memory_order_relaxed);
+  }
+
+  ~Impl() {
+    if (thread_active_.exchange(false)) {
+      PostQueuedCompletionStatus(port_, 0, 0, nullptr);
+      thread_.join();
+    }
+
+    for (auto& [id, endpoint] : endpoints_) {
+      for (auto& instance : endpoint->instances) CloseHandle(instance->pipe);
+    }
+
+    if (port_ != nullptr) CloseHandle(port_);
+  }
+
+ private:
+  void LoopThread() {
+    // carries on after being stopped until every closed instance's cancelled operation has come back, so that none are freed while queued
+    for (;;) {
+      DWORD bytes_transferred = 0;
+      ULONG_PTR key = 0;
+      OVERLAPPED* overlapped = nullptr;
+      const BOOL success = GetQueuedCompletionStatus(port_, &bytes_transferred, &key, &overlapped, INFINITE);
+      const DWORD error = success ? ERROR_SUCCESS : GetLastError();
+      wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+      std::scoped_lock lock(mutex_);
+
+      if (overlapped == nullptr) {
+        if (!success) {
+          LogError("Failed waiting for ipc events", "");
+          return;
+        }
+
+        if (!thread_active_ && closing_.empty()) return;
+        continue;
+      }
+
+      IpcPipeInstance* instance = reinterpret_cast<IpcPipeInstance*>(overlapped);
+      instance->pending = false;
+
+      if (instance->closing) {
+        std::erase_if(closing_, [&](const std::unique_ptr<IpcPipeInstance>& closing) { return closing.get() == instance; });
+
+        if (!thread_active_ && closing_.empty()) return;
+        continue;
+      }
+
+      OnCompleted(*instance, error, bytes_transferred);
+    }
+  }
+
+  void OnCompleted(IpcPipeInstance& instance, const DWORD error, const DWORD bytes_transferred) {
+    switch (instance.state) {
+      case IpcPipeInstanceState::Connecting:
+        if (error != ERROR_SUCCESS) {
+          LogError("Failed to connect to pipe client", instance.endpoint->name);
+          Recycle(instance);
+          return;
+        }
+
+        OnConnected(instance);
+        return;
+
+      case IpcPipeInstanceState::Reading:
+        if (error == ERROR_MORE_DATA) {
+          OG_LOG_EVERY_MS(
+              og::log_rate_limit_ms, og::kLoggerLevel_Error, "Pipe client sent a message that was too long (%s)", instance.endpoint->name.c_str());
+          Disconnect(instance);
+          return;
+        }
+
+        // the client went away
+        if (error != ERROR_SUCCESS || bytes_transferred == 0) {
+          Disconnect(instance);
+          return;
+        }
+
+        if (!instance.endpoint->on_message(instance.client, std::span<const char>(instance.buffer.data(), bytes_transferred))) {
+          Disconnect(instance);
+          return;
+        }
+
+        Read(instance);
+        return;
+    }
+  }
+
+  // creates an instance of the endpoint's pipe and waits for a client on it
+  bool AddInstance(IpcEndpoint& endpoint) {
+    auto instance = std::make_unique<IpcPipeInstance>();
+    instance->endpoint = &endpoint;
+    instance->buffer.resize(endpoint.max_message_length);
+
+    instance->pipe = CreateNamedPipeA(
+        endpoint.name.c_str(),
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
+        static_cast<DWORD>(ipc_max_clients),
+        0,
+        static_cast<DWORD>(endpoint.max_message_length),
+        0,
+        nullptr);
+
+    if (instance->pipe == INVALID_HANDLE_VALUE) {
+      LogError("CreateNamedPipe failed", endpoint.name);
+      return false;
+    }
+
+    if (CreateIoCompletionPort(instance->pipe, port_, 0, 0) == nullptr) {
+      LogError("Failed to add pipe to ipc event loop", endpoint.name);
+      CloseHandle(instance->pipe);
+      return false;
+    }
+
+    IpcPipeInstance* added = endpoint.instances.emplace_back(std::move(instance)).get();
+
+    // a new instance that can't wait for clients isn't replaced, as its replacement would most likely fail the same way
+    if (!Connect(*added)) {
+      RemoveInstance(*added);
+      return false;
+    }
+
+    return true;
+  }
+
+  // returns false if the instance is not waiting for a client and nothing is queued for it, which the caller has to deal with
+  bool Connect(IpcPipeInstance& instance) {
+    instance.overlapped = {};
+    instance.state = IpcPipeInstanceState::Connecting;
+
+    if (ConnectNamedPipe(instance.pipe, &instance.overlapped)) {
+      instance.pending = true;
+      return true;
+    }
+
+    switch (GetLastError()) {
+      case ERROR_IO_PENDING:
+        instance.pending = true;
+        return true;
+
+      // the client connected before we asked, so nothing is queued for it
+      case ERROR_PIPE_CONNECTED:
+        OnConnected(instance);
+        return true;
+
+      // the client connected and went away again before we asked
+      case ERROR_NO_DATA:
+        Recycle(instance);
+        return true;
+
+      default:
+        LogError("Failed to connect", instance.endpoint->name);
+        return false;
+    }
+  }
+
+  void OnConnected(IpcPipeInstance& instance) {
+    IpcEndpoint& endpoint = *instance.endpoint;
+    instance.client = next_client_++;
+
+    endpoint.on_event({.type = IpcListenerEventType::ClientConnected, .client = instance.client});
+
+    // keep another instance waiting for the next client, if there is room for one
+    if (endpoint.instances.size() < ipc_max_clients) AddInstance(endpoint);
+
+    Read(instance);
+  }
+
+  void Read(IpcPipeInstance& instance) {
+    instance.overlapped = {};
+    instance.state = IpcPipeInstanceState::Reading;
+
+    // a read that finishes straight away is still queued to the port, so is handled there either way
+    if (ReadFile(instance.pipe, instance.buffer.data(), static_cast<DWORD>(instance.buffer.size()), nullptr, &instance.overlapped)) {
+      instance.pending = true;
+      return;
+    }
+
+    switch (GetLastError()) {
+      case ERROR_IO_PENDING:
+      case ERROR_MORE_DATA:
+        instance.pending = true;
+        return;
+
+      default:
+        Disconnect(instance);
+        return;
+    }
+  }
+
+  // the client on instance is gone. The instance is closed if another is already waiting for the next client, and waits for it itself if not
+  void Disconnect(IpcPipeInstance& instance) {
+    IpcEndpoint& endpoint = *instance.endpoint;
+
+    const uint64_t client = instance.client;
+    instance.client = 0;
+    endpoint.on_event({.type = IpcListenerEventType::ClientDisconnected, .client = client});
+
+    const bool another_waiting = std::any_of(endpoint.instances.begin(), endpoint.instances.end(), [&](const auto& other) {
+      return other.get() != &instance && other->state == IpcPipeInstanceState::Connecting;
+    });
+    if (!another_waiting) {
+      Recycle(instance);
+      return;
+    }
+
+    RemoveInstance(instance);
+  }
+
+  // instance waits for the next client again. If it can't, it is closed (so is gone once this returns) and a new instance waits in its place
+  void Recycle(IpcPipeInstance& instance) {
+    if (!DisconnectNamedPipe(instance.pipe)) LogError("Failed to disconnect", instance.endpoint->name);
+    if (Connect(instance)) return;
+
+    // otherwise the endpoint would stop taking clients until it is removed
+    IpcEndpoint& endpoint = *instance.endpoint;
+    RemoveInstance(instance);
+    AddInstance(endpoint);
+  }
+
+  // instance is gone once this returns
+  void RemoveInstance(IpcPipeInstance& instance) {
+    IpcEndpoint& endpoint = *instance.endpoint;
+
+    const auto it = std::find_if(endpoint.instances.begin(), endpoint.instances.end(), [&](const auto& other) { return other.get() == &instance; });
+    std::unique_ptr<IpcPipeInstance> closed = std::move(*it);
+    endpoint.instances.erase(it);
+
+    CloseInstance(std::move(closed));
+  }
+
+  void CloseInstance(std::unique_ptr<IpcPipeInstance> instance) {
+    // closing the pipe cancels what is queued on it, but the instance has to be kept until the loop takes the cancelled completion
+    CloseHandle(instance->pipe);
+    if (instance->pending) {
+      instance->closing = true;
+      closing_.push_back(std::move(instance));
+    }
+  }
+
+  static void LogError(const char* message, const std::string& name) {
+    logger.Log(og::kLoggerLevel_Error, "%s (%s) - Error: %s", message, name.c_str(), GetLastErrorAsString().c_str());
+  }
+
+  HANDLE port_ = nullptr;
+
+  // held while handling a completion, so that an endpoint can't be removed from under its callbacks
+  std::mutex mutex_;
+  std::map<uint64_t, std::unique_ptr<IpcEndpoint>> endpoints_;
+  std::vector<std::unique_ptr<IpcPipeInstance>> closing_;
+  uint64_t next_endpoint_ = 1;
+  uint64_t next_client_ = 1;
+
+  std::atomic<bool> thread_active_ = false;
+  std::thread thread_;
+
+  std::atomic<uint64_t> wakeups_ = 0;
+};
+
+IpcEventLoop::IpcEventLoop() : pImpl_(std::make_unique<Impl>()) {}
+
+uint64_t IpcEventLoop::AddEndpoint(
+    const std::string& name,
+    const size_t max_message_length,
+    std::function<void(const IpcListenerEvent& event)> on_event,
+    std::function<bool(uint64_t client, std::span<const char> message)> on_message) {
+  return pImpl_->AddEndpoint(name, max_message_length, std::move(on_event), std::move(on_message));
+}
+
+void IpcEventLoop::RemoveEndpoint(const uint64_t endpoint) {
+  pImpl_->RemoveEndpoint(endpoint);
+}
+
+uint64_t IpcEventLoop::GetWakeups() {
+  return pImpl_->GetWakeups();
+}
+
+IpcEventLoop::~IpcEventLoop() = default;
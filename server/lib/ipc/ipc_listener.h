@@ -0,0 +1,104 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "ipc/ipc_event_loop.h"
+
+class IIpcListener {
+ public:
+  virtual bool StartListening() = 0;
+
+  virtual ~IIpcListener() = default;
+};
+
+// an endpoint on the shared ipc event loop that clients write T to, one whole T per message. on_data_callback is told which client sent it, and is
+// given the T where it arrived rather than a copy
+template <typename T>
+class IpcListener : public IIpcListener {
+ public:
+  IpcListener(
+      std::string name,
+      std::function<void(const IpcListenerEvent& event)> on_event_callback,
+      std::function<void(uint64_t client, const T*)> on_data_callback)
+      : name_(std::move(name)), on_event_callback_(std::move(on_event_callback)), on_data_callback_(std::move(on_data_callback)){};
+
+  bool StartListening() override {
+    // already listening
+    if (endpoint_ != 0) return false;
+
+    event_loop_ = IpcEventLoop::Acquire();
+    endpoint_ = event_loop_->AddEndpoint(name_, sizeof(T), on_event_callback_, [&](const uint64_t client, const std::span<const char> message) {
+      static_assert(alignof(T) <= alignof(std::max_align_t), "messages are only aligned for fundamental types");
+      if (message.size() != sizeof(T)) return false;
+
+      on_data_callback_(client, reinterpret_cast<const T*>(message.data()));
+
+      return true;
+    });
+
+    return endpoint_ != 0;
+  }
+
+  ~IpcListener() override {
+    if (endpoint_ != 0) event_loop_->RemoveEndpoint(endpoint_);
+  }
+
+ private:
+  std::string name_;
+
+  std::shared_ptr<IpcEventLoop> event_loop_;
+  uint64_t endpoint_ = 0;
+
+  std::function<void(const IpcListenerEvent& event)> on_event_callback_;
+  std::function<void(uint64_t client, const T*)> on_data_callback_;
+};
+
+// an endpoint on the shared ipc event loop that clients write messages of any length up to max_message_length to, which on_message_callback makes
+// sense of itself. Returning false from it disconnects the client
+class IpcMessageListener : public IIpcListener {
+ public:
+  IpcMessageListener(
+      std::string name,
+      const size_t max_message_length,
+      std::function<void(const IpcListenerEvent& event)> on_event_callback,
+      std::function<bool(uint64_t client, std::span<const char> message)> on_message_callback)
+      : name_(std::move(name)),
+        max_message_length_(max_message_length),
+        on_event_callback_(std::move(on_event_callback)),
+        on_message_callback_(std::move(on_message_callback)){};
+
+  bool StartListening() override {
+    // already listening
+    if (endpoint_ != 0) return false;
+
+    event_loop_ = IpcEventLoop::Acquire();
+    endpoint_ = event_loop_->AddEndpoint(name_, max_message_length_, on_event_callback_, on_message_callback_);
+
+    return endpoint_ != 0;
+  }
+
+  ~IpcMessageListener() override {
+    if (endpoint_ != 0) event_loop_->RemoveEndpoint(endpoint_);
+  }
+
+ private:
+  std::string name_;
+  size_t max_message_length_;
+
+  std::shared_ptr<IpcEventLoop> event_loop_;
+  uint64_t endpoint_ = 0;
+
+  std::function<void(const IpcListenerEvent& event)> on_event_callback_;
+  std::function<bool(uint64_t client, std::span<const char> message)> on_message_callback_;
+};
@@ -0,0 +1,243 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <thread>
+#endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "opengloves_interface.h"
+
+/**
+ * A named shared memory segment (one per hand) that a software input source (ie. a hand tracking app) publishes its newest frame to, without a
+ * round trip through a pipe per sample. The segment lives in POSIX shared memory on linux (/dev/shm/<name>) and in a named file mapping on windows
+ * (Local\<name>), and has the layout of SharedMemoryInputSegment.
+ *
+ * There is one producer per segment, which publishes through a seqlock: sequence is made odd, the frame is written, then sequence is made even again.
+ * A reader copies the frame between two loads of sequence, and keeps the copy only if both were the same even value, so it always gets the newest
+ * whole frame and never holds the producer up. Frames published faster than the server reads them are overwritten.
+ *
+ * The server sets waiting while it is blocked waiting for a frame, and only then does the producer wake it (a futex on sequence on linux, a named
+ * event on windows), so a producer publishing to a busy server makes no syscalls at all.
+ *
+ * The server creates the segment, and producers open it. Either side can restart without the other: the segment is left in place for whichever
+ * opens it next.
+ */
+static constexpr uint32_t shared_memory_input_magic = 0x4d53474f;  // "OGSM"
+static constexpr uint32_t shared_memory_input_version = 1;
+
+struct SharedMemoryInputFrame {
+  uint64_t frame;         // counts up by one for each frame published, across producer restarts
+  int64_t timestamp_ns;   // the producer's steady clock (CLOCK_MONOTONIC, or QueryPerformanceCounter) when it was published
+  og::InputPeripheralData data;
+};
+
+struct SharedMemoryInputSegment {
+  std::atomic<uint32_t> magic;  // set last by the server, once the rest of the segment is ready
+  uint32_t version;
+
+  std::atomic<uint32_t> sequence;  // odd while the producer is writing the frame
+  std::atomic<uint32_t> waiting;   // non zero while the server is waiting to be woken for the next frame
+
+  SharedMemoryInputFrame frame;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory atomics must not need a lock");
+
+// the name of the segment the server creates for each hand
+inline std::string GetSharedMemoryInputName(const og::Hand hand) {
+  return std::string("opengloves_input_") + (hand == og::kHandLeft ? "left" : "right");
+}
+
+class SharedMemoryInput {
+ public:
+  // for the server. The segment may already exist if a producer (or a server before this one) still has it open, in which case it is kept as it is
+  static std::unique_ptr<SharedMemoryInput> Create(const std::string& name) {
+    std::unique_ptr<SharedMemoryInput> result(new SharedMemoryInput());
+    if (!result->Map(name, true)) return nullptr;
+
+    SharedMemoryInputSegment* segment = result->segment_;
+    if (segment->magic.load(std::memory_order_acquire) != shared_memory_input_magic || segment->version != shared_memory_input_version) {
+      segment->sequence.store(0, std::memory_order_relaxed);
+      segment->waiting.store(0, std::memory_order_relaxed);
+      std::memset(&segment->frame, 0, sizeof segment->frame);
+      segment->version = shared_memory_input_version;
+
+      segment->magic.store(shared_memory_input_magic, std::memory_order_release);
+    }
+
+    return result;
+  }
+
+  // for producers. Fails if the server has not created the segment yet
+  static std::unique_ptr<SharedMemoryInput> Open(const std::string& name) {
+    std::unique_ptr<SharedMemoryInput> result(new SharedMemoryInput());
+    if (!result->Map(name, false)) return nullptr;
+
+    const SharedMemoryInputSegment* segment = result->segment_;
+    if (segment->magic.load(std::memory_order_acquire) != shared_memory_input_magic || segment->version != shared_memory_input_version) {
+      return nullptr;
+    }
+
+    return result;
+  }
+
+  void Publish(const og::InputPeripheralData& data) {
+    // a producer that died mid write left the sequence odd, which this write carries on from
+    const uint32_t writing = segment_->sequence.load(std::memory_order_relaxed) | 1;
+    segment_->sequence.store(writing, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    segment_->frame.frame++;
+    segment_->frame.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    segment_->frame.data = data;
+
+    // sequentially consistent so that it can't pass the load of waiting, or the server could go to sleep on a frame it had missed
+    segment_->sequence.store(writing + 1, std::memory_order_seq_cst);
+    if (segment_->waiting.load(std::memory_order_seq_cst) != 0) Wake();
+  }
+
+  // copies the newest frame. Fails if the producer was writing the whole time (ie. it died mid write), out_sequence is what was seen either way
+  bool Read(SharedMemoryInputFrame& out_frame, uint32_t& out_sequence) const {
+    static constexpr int max_attempts = 64;
+
+    for (int attempt = 0; attempt < max_attempts; attempt++) {
+      out_sequence = segment_->sequence.load(std::memory_order_acquire);
+      if (out_sequence & 1) continue;
+
+      std::memcpy(&out_frame, &segment_->frame, sizeof out_frame);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (segment_->sequence.load(std::memory_order_relaxed) == out_sequence) return true;
+    }
+
+    return false;
+  }
+
+  [[nodiscard]] uint32_t GetSequence() const {
+    return segment_->sequence.load(std::memory_order_acquire);
+  }
+
+  // waits until the sequence moves on from read_sequence (the one the last read saw). Returns false if it didn't within timeout
+  bool WaitForPublish(const uint32_t read_sequence, const std::chrono::milliseconds timeout) {
+    segment_->waiting.store(1, std::memory_order_seq_cst);
+    if (segment_->sequence.load(std::memory_order_seq_cst) == read_sequence) Wait(read_sequence, timeout);
+    segment_->waiting.store(0, std::memory_order_relaxed);
+
+    return GetSequence() != read_sequence;
+  }
+
+  ~SharedMemoryInput() {
+#ifdef _WIN32
+    if (segment_ != nullptr) UnmapViewOfFile(segment_);
+    if (mapping_ != nullptr) CloseHandle(mapping_);
+    if (published_event_ != nullptr) CloseHandle(published_event_);
+#else
+    if (segment_ != nullptr) munmap(segment_, sizeof(SharedMemoryInputSegment));
+#endif
+  }
+
+ private:
+  SharedMemoryInput() = default;
+
+#ifdef _WIN32
+  bool Map(const std::string& name, const bool create) {
+    const std::string mapping_name = "Local\\" + name;
+    if (create) {
+      mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(SharedMemoryInputSegment), mapping_name.c_str());
+    } else {
+      mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mapping_name.c_str());
+    }
+    if (mapping_ == nullptr) return false;
+
+    segment_ = static_cast<SharedMemoryInputSegment*>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedMemoryInputSegment)));
+    if (segment_ == nullptr) return false;
+
+    // auto reset, as there is only the one reader to wake
+    published_event_ = CreateEventA(nullptr, FALSE, FALSE, (mapping_name + "_published").c_str());
+
+    return published_event_ != nullptr;
+  }
+
+  void Wait(uint32_t, const std::chrono::milliseconds timeout) {
+    WaitForSingleObject(published_event_, static_cast<DWORD>(timeout.count()));
+  }
+
+  void Wake() {
+    SetEvent(published_event_);
+  }
+
+  HANDLE mapping_ = nullptr;
+  HANDLE published_event_ = nullptr;
+#else
+  bool Map(const std::string& name, const bool create) {
+    const std::string object_name = "/" + name;
+    const int fd = shm_open(object_name.c_str(), create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+    if (fd < 0) return false;
+
+    // a new object is empty, and comes out zeroed once sized
+    struct stat status {};
+    if (fstat(fd, &status) != 0 || (static_cast<size_t>(status.st_size) < sizeof(SharedMemoryInputSegment) &&
+                                    (!create || ftruncate(fd, sizeof(SharedMemoryInputSegment)) != 0))) {
+      close(fd);
+      return false;
+    }
+
+    void* mapped = mmap(nullptr, sizeof(SharedMemoryInputSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    segment_ = static_cast<SharedMemoryInputSegment*>(mapped);
+
+    return true;
+  }
+
+#ifdef __linux__
+  // not FUTEX_PRIVATE_FLAG, as the producer is another process
+  void Wait(const uint32_t read_sequence, const std::chrono::milliseconds timeout) {
+    const timespec relative = {
+        .tv_sec = static_cast<time_t>(timeout.count() / 1000),
+        .tv_nsec = static_cast<long>(timeout.count() % 1000 * 1000000),
+    };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&segment_->sequence), FUTEX_WAIT, read_sequence, &relative, nullptr, 0);
+  }
+
+  void Wake() {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&segment_->sequence), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+#else
+  // without a futex to wait on, the sequence is checked every millisecond
+  void Wait(const uint32_t read_sequence, const std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (GetSequence() == read_sequence && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  void Wake() {}
+#endif
+#endif
+
+  SharedMemoryInputSegment* segment_ = nullptr;
+};
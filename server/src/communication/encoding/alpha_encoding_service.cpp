@@ -7,14 +7,21 @@
 #include "communication/encoding/alpha_encoding_service.h"
 
 #include <algorithm>
-#include <map>
-#include <stdexcept>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+
+#include "util/byte_scanner.h"
 
 static og::Logger& logger = og::Logger::GetInstance();
 
-static const int max_analog_value = 4095;
+struct AlphaEncodingInputKey {
+  std::string_view key;
+  AlphaEncodingKey value;
+};
 
-static const std::map<std::string, AlphaEncodingKey> alpha_encoding_input_key_strings{
+static constexpr std::array<AlphaEncodingInputKey, 47> alpha_encoding_input_keys{{
     {"A", kAlphaEncodingKey_ThumbCurl},           // whole thumb curl
     {"(AB)", kAlphaEncodingKey_ThumbSplay},       // whole thumb splay
     {"B", kAlphaEncodingKey_IndexCurl},           // whole index curl
@@ -58,18 +65,25 @@ static const std::map<std::string, AlphaEncodingKey> alpha_encoding_input_key_st
     {"P", kAlphaEncodingKey_Trigger_Value},       // analog trigger value
 
     {"Z", kAlphaEncodingKey_Info},
-    {"(ZV)", kAlphaEncodingKey_Info_FWVersion},   // firmware version
-    {"(ZG)", kAlphaEncodingKey_Info_DeviceType},  // glove type (ie lucidgloves)
-    {"(ZH)", kAlphaEncodingKey_Info_Hand},        // hand (left/right)
-
-    {"", kAlphaEncodingKey_Max}  // Junk key
+    {"(ZV)", kAlphaEncodingKey_Info_FWVersion},         // firmware version
+    {"(ZG)", kAlphaEncodingKey_Info_DeviceType},        // glove type (ie lucidgloves)
+    {"(ZH)", kAlphaEncodingKey_Info_Hand},              // hand (left/right)
+    {"(ZE)", kAlphaEncodingKey_Info_Encodings},         // supported encodings (bitfield of 1 << og::EncodingType)
+    {"(ZB)", kAlphaEncodingKey_Info_AnalogResolution},  // highest analog resolution, in bits
+}};
+
+struct AlphaEncodingOutputKey {
+  AlphaEncodingKey key;
+  std::string_view value;
 };
 
-static const std::map<AlphaEncodingKey, std::string> alpha_encoding_output_key_strings{
+static constexpr std::array<AlphaEncodingOutputKey, 13> alpha_encoding_output_keys{{
     {kAlphaEncodingKey_Info, "Z"},
 
     {kAlphaEncodingKey_Info_StartStreaming, "(ZA)"},
     {kAlphaEncodingKey_Info_StopStreaming, "(ZZ)"},
+    {kAlphaEncodingKey_Info_Encodings, "(ZE)"},         // encoding to switch to
+    {kAlphaEncodingKey_Info_AnalogResolution, "(ZB)"},  // analog resolution to switch to, in bits
 
     {kAlphaEncodingKey_ThumbCurl, "A"},   // thumb force feedback
     {kAlphaEncodingKey_IndexCurl, "B"},   // index force feedback
@@ -80,236 +94,594 @@ static const std::map<AlphaEncodingKey, std::string> alpha_encoding_output_key_s
     {kAlphaEncodingKey_OutHapticFrequency, "F"},  // haptic vibration frequency
     {kAlphaEncodingKey_OutHapticDuration, "G"},   // haptic vibration duration
     {kAlphaEncodingKey_OutHapticAmplitude, "H"},  // haptic vibration amplitude
-};
+}};
+
+// indexed by key, so encoding doesn't need to search for the key strings
+static constexpr std::array<std::string_view, kAlphaEncodingKey_Max> BuildOutputKeyStrings() {
+  std::array<std::string_view, kAlphaEncodingKey_Max> result{};
+  for (const auto& [key, value] : alpha_encoding_output_keys) result[key] = value;
+
+  return result;
+}
+
+static constexpr std::array<std::string_view, kAlphaEncodingKey_Max> alpha_encoding_output_key_strings = BuildOutputKeyStrings();
 
-static const std::string alpha_encoding_key_characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ()";
+static_assert(kAlphaEncodingKey_Max < 64, "Alpha encoding keys must fit into a 64 bit presence mask");
 
-static bool CharacterIsValid(const std::string& buff, size_t index) {
-  return index < buff.length() && buff[index] < 255 && buff[index] >= 0;
+// Keys are at most three letters, optionally wrapped in parentheses. The letters are packed in base 27 ('A' = 1) to index flat lookup tables, so
+// resolving a key is a single array access rather than a string comparison.
+static constexpr int alpha_packed_key_radix = 27;
+static constexpr int alpha_packed_key_count = alpha_packed_key_radix * alpha_packed_key_radix * alpha_packed_key_radix;
+
+static constexpr bool IsKeyLetter(const char character) {
+  return ClassifyByte(character) == kByteClass_Letter;
 }
 
-static bool CharacterIsKeyCharacter(const char character) {
-  return alpha_encoding_key_characters.find(character) != std::string::npos;
+// returns -1 if the letters cannot be packed
+static constexpr int PackKeyLetters(std::string_view letters) {
+  if (letters.empty() || letters.length() > 3) return -1;
+
+  int result = 0;
+  for (const char letter : letters) {
+    if (!IsKeyLetter(letter)) return -1;
+
+    result = result * alpha_packed_key_radix + (letter - 'A' + 1);
+  }
+
+  return result;
+}
+
+struct AlphaEncodingKeyLookup {
+  std::array<AlphaEncodingKey, alpha_packed_key_radix> bare;
+  std::array<AlphaEncodingKey, alpha_packed_key_count> parenthesised;
+};
+
+static constexpr AlphaEncodingKeyLookup BuildKeyLookup() {
+  AlphaEncodingKeyLookup result{};
+  result.bare.fill(kAlphaEncodingKey_Max);
+  result.parenthesised.fill(kAlphaEncodingKey_Max);
+
+  for (const auto& [key, value] : alpha_encoding_input_keys) {
+    if (key.front() == '(')
+      result.parenthesised[PackKeyLetters(key.substr(1, key.length() - 2))] = value;
+    else
+      result.bare[PackKeyLetters(key)] = value;
+  }
+
+  return result;
 }
 
-static inline bool KeyInMap(AlphaEncodingKey key, const std::map<AlphaEncodingKey, std::string>& map) {
-  return map.find(key) != map.end();
+static constexpr AlphaEncodingKeyLookup alpha_encoding_key_lookup = BuildKeyLookup();
+
+static AlphaEncodingKey LookupKey(std::string_view key) {
+  if (key.length() == 1) {
+    const int packed = PackKeyLetters(key);
+    return packed < 0 ? kAlphaEncodingKey_Max : alpha_encoding_key_lookup.bare[packed];
+  }
+
+  // a parenthesised key always has at least two letters, "(A)" is not a valid key
+  if (key.length() < 4 || key.front() != '(' || key.back() != ')') return kAlphaEncodingKey_Max;
+
+  const int packed = PackKeyLetters(key.substr(1, key.length() - 2));
+  return packed < 0 ? kAlphaEncodingKey_Max : alpha_encoding_key_lookup.parenthesised[packed];
 }
 
-static std::map<AlphaEncodingKey, std::string> ParseToMap(const std::string& buff) {
-  std::map<AlphaEncodingKey, std::string> result;
+// the digits after a key. status is kDecodeStatus_Ok, kDecodeStatus_MissingValue or kDecodeStatus_NumberOverflow
+struct AlphaEncodingValue {
+  uint32_t integer;
+  og::DecodeStatus status;
+};
+
+struct AlphaEncodingPacket {
+  uint64_t present;
+  std::array<AlphaEncodingValue, kAlphaEncodingKey_Max> values;
+
+  // problems found while scanning that do not stop the packet from being used
+  og::DecodeStatus status;
 
-  size_t i = 0;
-  while (i < buff.length()) {
-    std::string current_key = "";
+  [[nodiscard]] bool Contains(AlphaEncodingKey key) const {
+    return (present >> key) & 1;
+  }
+};
 
-    // parse a key
-    if (buff[i] == '(') {
-      while (CharacterIsValid(buff, i) && CharacterIsKeyCharacter(buff[i])) {
-        current_key += buff[i];
-        i++;
+// every key before kAlphaEncodingKey_Info is peripheral data
+static constexpr uint64_t alpha_encoding_peripheral_keys = (uint64_t{1} << kAlphaEncodingKey_Info) - 1;
+static constexpr uint64_t alpha_encoding_info_keys =
+    (uint64_t{1} << kAlphaEncodingKey_Info_FWVersion) | (uint64_t{1} << kAlphaEncodingKey_Info_DeviceType) |
+    (uint64_t{1} << kAlphaEncodingKey_Info_Hand) | (uint64_t{1} << kAlphaEncodingKey_Info_Encodings) |
+    (uint64_t{1} << kAlphaEncodingKey_Info_AnalogResolution);
+
+enum AlphaEncodingScanMode {
+  kAlphaEncodingScanMode_Key,               // between tokens, looking for the start of a key
+  kAlphaEncodingScanMode_ParenthesisedKey,  // inside a key that started with '('
+  kAlphaEncodingScanMode_Value,             // reading the digits after a key
+};
+
+// The longest key is "(AAA)", so only this much of a key that is split between chunks needs to be kept to look it up. Once full, the last
+// character is overwritten instead so that a key that was cut off can still be told apart from an unknown one.
+static constexpr size_t alpha_max_saved_key_length = 6;
+
+// Tokenises packets one byte range at a time. All state is kept between calls so that a packet can be split at any byte, which lets stream
+// decoding work straight from whatever a transport read.
+class AlphaEncodingScanner {
+ public:
+  AlphaEncodingScanner() {
+    Reset();
+  }
+
+  void Reset() {
+    packet_.present = 0;
+    packet_.status = og::kDecodeStatus_Ok;
+    mode_ = kAlphaEncodingScanMode_Key;
+  }
+
+  // scans up to and including the first newline. Returns the number of bytes used, out_line_ended is set if a newline was found
+  size_t Scan(std::string_view data, bool& out_line_ended) {
+    out_line_ended = false;
+
+    const size_t length = data.length();
+    size_t i = 0;
+
+    // the state is worked on in locals and only written back once the call returns, which keeps it in registers for the hot loops
+    AlphaEncodingScanMode mode = mode_;
+    uint64_t integer = integer_;
+    bool has_digits = has_digits_;
+
+    // where the current key is in data. Keys that started in an earlier call are in saved_key_ instead
+    size_t key_begin = std::string_view::npos;
+    size_t key_end = 0;
+
+    while (i < length) {
+      // the stages run in order for every token, a chunk that ends part way through a token resumes at the stage it stopped in
+      if (mode == kAlphaEncodingScanMode_Key) {
+        const char character = data[i++];
+        if (character == '\n') {
+          out_line_ended = true;
+          break;
+        }
+
+        const uint8_t byte_class = ClassifyByte(character);
+        if (!(byte_class & kByteClass_Key)) continue;
+
+        key_begin = i - 1;
+        key_end = i;
+        integer = 0;
+        has_digits = false;
+
+        mode = byte_class == kByteClass_OpenParen ? kAlphaEncodingScanMode_ParenthesisedKey : kAlphaEncodingScanMode_Value;
       }
-    } else if (CharacterIsKeyCharacter(buff[i])) {
-      current_key = buff[i];
-      i++;
-    } else {
-      i++;
-      continue;
+
+      if (mode == kAlphaEncodingScanMode_ParenthesisedKey) {
+        const size_t begin = i;
+        while (i < length && (ClassifyByte(data[i]) & kByteClass_Key)) i++;
+
+        if (key_begin == std::string_view::npos)
+          SaveKey(data.substr(begin, i - begin));
+        else
+          key_end = i;
+
+        if (i == length) break;
+        mode = kAlphaEncodingScanMode_Value;
+      }
+
+      const size_t begin = i;
+      for (; i < length && ClassifyByte(data[i]) == kByteClass_Digit; i++) {
+        // saturate rather than wrap, anything above uint32 max is an overflow anyway
+        if (integer <= std::numeric_limits<uint32_t>::max()) integer = integer * 10 + (data[i] - '0');
+      }
+      if (i > begin) has_digits = true;
+
+      if (i == length) break;
+
+      FinishToken(key_begin == std::string_view::npos ? SavedKey() : data.substr(key_begin, key_end - key_begin), integer, has_digits);
+      key_begin = std::string_view::npos;
+      mode = kAlphaEncodingScanMode_Key;
+    }
+
+    // the chunk ended part way through a token, keep the key for the next call
+    if (mode != kAlphaEncodingScanMode_Key && key_begin != std::string_view::npos) {
+      saved_key_length_ = 0;
+      SaveKey(data.substr(key_begin, key_end - key_begin));
     }
 
-    // we have a valid key
-    std::string current_value = "";
-    while (CharacterIsValid(buff, i) && isdigit(buff[i])) {
-      current_value += buff[i];
+    mode_ = mode;
+    integer_ = integer;
+    has_digits_ = has_digits;
+
+    return i;
+  }
 
-      i++;
+  // completes the token the packet ended on. Only needed when the packet was not ended by a newline
+  void Finish() {
+    if (mode_ == kAlphaEncodingScanMode_Key) return;
+
+    FinishToken(SavedKey(), integer_, has_digits_);
+    mode_ = kAlphaEncodingScanMode_Key;
+  }
+
+  [[nodiscard]] const AlphaEncodingPacket& GetPacket() const {
+    return packet_;
+  }
+
+ private:
+  void SaveKey(std::string_view part) {
+    for (const char character : part) {
+      if (saved_key_length_ < alpha_max_saved_key_length)
+        saved_key_[saved_key_length_++] = character;
+      else
+        saved_key_.back() = character;
+    }
+  }
+
+  [[nodiscard]] std::string_view SavedKey() const {
+    return {saved_key_.data(), saved_key_length_};
+  }
+
+  void FinishToken(std::string_view key_string, const uint64_t integer, const bool has_digits) {
+    const AlphaEncodingKey key = LookupKey(key_string);
+
+    if (key == kAlphaEncodingKey_Max) {
+      const bool truncated = key_string.front() == '(' && key_string.back() != ')';
+      if (packet_.status == og::kDecodeStatus_Ok) packet_.status = truncated ? og::kDecodeStatus_Truncated : og::kDecodeStatus_UnknownKey;
+      return;
     }
 
-    if (alpha_encoding_input_key_strings.find(current_key) != alpha_encoding_input_key_strings.end()) {
-      result.insert_or_assign(alpha_encoding_input_key_strings.at(current_key), current_value);
+    AlphaEncodingValue& value = packet_.values[key];
+    if (!has_digits) {
+      value = {0, og::kDecodeStatus_MissingValue};
+    } else if (integer > std::numeric_limits<uint32_t>::max()) {
+      value = {0, og::kDecodeStatus_NumberOverflow};
     } else {
-      logger.Log(og::kLoggerLevel_Warning, "Unable to insert key as it was not found in map: %s", current_key.c_str());
+      value = {static_cast<uint32_t>(integer), og::kDecodeStatus_Ok};
     }
+
+    packet_.present |= uint64_t{1} << key;
   }
 
-  return result;
-}
+  // values are only read for keys marked present, so they are left uninitialised rather than cleared for every packet
+  AlphaEncodingPacket packet_;
+  AlphaEncodingScanMode mode_ = kAlphaEncodingScanMode_Key;
 
-AlphaEncodingService::AlphaEncodingService(const og::DeviceAlphaEncodingConfiguration& encoding_configuration) {
-  configuration_ = encoding_configuration;
-}
+  std::array<char, alpha_max_saved_key_length> saved_key_{};
+  size_t saved_key_length_ = 0;
+
+  uint64_t integer_ = 0;
+  bool has_digits_ = false;
+};
+
+enum AlphaEncodingAnalogScale {
+  kAlphaEncodingAnalogScale_Unit,      // 0.0f -> 1.0f inclusive
+  kAlphaEncodingAnalogScale_Splay,     // -1.0f -> 1.0f inclusive
+  kAlphaEncodingAnalogScale_Joystick,  // -1.0f -> 1.0f inclusive
+};
+
+struct AlphaEncodingAnalogChannel {
+  AlphaEncodingKey key;
+  AlphaEncodingAnalogScale scale;
+  float& (*field)(og::InputPeripheralData&);
+};
+
+struct AlphaEncodingDigitalChannel {
+  AlphaEncodingKey key;
+  bool& (*field)(og::InputPeripheralData&);
+};
 
-og::InputPeripheralData AlphaEncodingService::DecodePeripheralPacket(const std::map<AlphaEncodingKey, std::string>& input_map) {
-  og::InputPeripheralData result{};
+// analog values that are written straight into the peripheral data. Joint curls are handled separately as they fall back to the whole finger curl.
+static constexpr std::array<AlphaEncodingAnalogChannel, 8> alpha_encoding_analog_channels{{
+    {kAlphaEncodingKey_ThumbSplay, kAlphaEncodingAnalogScale_Splay, [](og::InputPeripheralData& data) -> float& { return data.splay[0]; }},
+    {kAlphaEncodingKey_IndexSplay, kAlphaEncodingAnalogScale_Splay, [](og::InputPeripheralData& data) -> float& { return data.splay[1]; }},
+    {kAlphaEncodingKey_MiddleSplay, kAlphaEncodingAnalogScale_Splay, [](og::InputPeripheralData& data) -> float& { return data.splay[2]; }},
+    {kAlphaEncodingKey_RingSplay, kAlphaEncodingAnalogScale_Splay, [](og::InputPeripheralData& data) -> float& { return data.splay[3]; }},
+    {kAlphaEncodingKey_PinkySplay, kAlphaEncodingAnalogScale_Splay, [](og::InputPeripheralData& data) -> float& { return data.splay[4]; }},
+
+    {kAlphaEncodingKey_MainJoystick_X, kAlphaEncodingAnalogScale_Joystick, [](og::InputPeripheralData& data) -> float& { return data.joystick.x; }},
+    {kAlphaEncodingKey_MainJoystick_Y, kAlphaEncodingAnalogScale_Joystick, [](og::InputPeripheralData& data) -> float& { return data.joystick.y; }},
+
+    {kAlphaEncodingKey_Trigger_Value, kAlphaEncodingAnalogScale_Unit, [](og::InputPeripheralData& data) -> float& { return data.trigger.value; }},
+}};
+
+// values where only the presence of the key matters
+static constexpr std::array<AlphaEncodingDigitalChannel, 8> alpha_encoding_digital_channels{{
+    {kAlphaEncodingKey_MainJoystick_Click, [](og::InputPeripheralData& data) -> bool& { return data.joystick.pressed; }},
+    {kAlphaEncodingKey_Trigger_Click, [](og::InputPeripheralData& data) -> bool& { return data.trigger.pressed; }},
+    {kAlphaEncodingKey_A_Click, [](og::InputPeripheralData& data) -> bool& { return data.A.pressed; }},
+    {kAlphaEncodingKey_B_Click, [](og::InputPeripheralData& data) -> bool& { return data.B.pressed; }},
+    {kAlphaEncodingKey_Grab_Gesture, [](og::InputPeripheralData& data) -> bool& { return data.grab.activated; }},
+    {kAlphaEncodingKey_Pinch_Gesture, [](og::InputPeripheralData& data) -> bool& { return data.pinch.activated; }},
+    {kAlphaEncodingKey_Menu_Click, [](og::InputPeripheralData& data) -> bool& { return data.menu.pressed; }},
+    {kAlphaEncodingKey_Calibration_Click, [](og::InputPeripheralData& data) -> bool& { return data.calibrate.pressed; }},
+}};
+
+static og::DecodeStatus DecodePeripheralPacket(const AlphaEncodingPacket& packet, const float max_analog_value, og::InputPeripheralData& out_data) {
+  if ((packet.present & alpha_encoding_peripheral_keys) == 0) return og::kDecodeStatus_Empty;
 
   // default flexion curl values for the whole finger
   std::array<float, 5> flexion{};
   flexion.fill(-1.0f);
 
   // parse full finger curls first in a temporary array (so we can fallback to them if needed)
-  if (KeyInMap(kAlphaEncodingKey_ThumbCurl, input_map))
-    flexion[0] = std::stof(input_map.at(kAlphaEncodingKey_ThumbCurl)) / configuration_.max_analog_value;
-  if (KeyInMap(kAlphaEncodingKey_IndexCurl, input_map))
-    flexion[1] = std::stof(input_map.at(kAlphaEncodingKey_IndexCurl)) / configuration_.max_analog_value;
-  if (KeyInMap(kAlphaEncodingKey_MiddleCurl, input_map))
-    flexion[2] = std::stof(input_map.at(kAlphaEncodingKey_MiddleCurl)) / configuration_.max_analog_value;
-  if (KeyInMap(kAlphaEncodingKey_RingCurl, input_map))
-    flexion[3] = std::stof(input_map.at(kAlphaEncodingKey_RingCurl)) / configuration_.max_analog_value;
-  if (KeyInMap(kAlphaEncodingKey_PinkyCurl, input_map))
-    flexion[4] = std::stof(input_map.at(kAlphaEncodingKey_PinkyCurl)) / configuration_.max_analog_value;
-
-  int current_joint = kAlphaEncodingKey_ThumbJoint0;
+  for (int i = 0; i < 5; i++) {
+    const auto curl_key = static_cast<AlphaEncodingKey>(kAlphaEncodingKey_ThumbCurl + i * 2);
+    if (!packet.Contains(curl_key)) continue;
+
+    const AlphaEncodingValue& value = packet.values[curl_key];
+    if (value.status != og::kDecodeStatus_Ok) return value.status;
+    flexion[i] = static_cast<float>(value.integer) / max_analog_value;
+  }
 
   // fill individual joint curls
   for (int i = 0; i < 5; i++) {
     for (int j = 0; j < 4; j++) {
-      AlphaEncodingKey joint = static_cast<AlphaEncodingKey>(current_joint);
-      result.flexion[i][j] = input_map.find(joint) != input_map.end() ? std::stof(input_map.at(joint)) / configuration_.max_analog_value : flexion[i];
+      const auto joint_key = static_cast<AlphaEncodingKey>(kAlphaEncodingKey_ThumbJoint0 + i * 4 + j);
+      if (!packet.Contains(joint_key)) {
+        out_data.flexion[i][j] = flexion[i];
+        continue;
+      }
 
-      current_joint++;
+      const AlphaEncodingValue& value = packet.values[joint_key];
+      if (value.status != og::kDecodeStatus_Ok) return value.status;
+      out_data.flexion[i][j] = static_cast<float>(value.integer) / max_analog_value;
     }
   }
 
-  // splay: -1.0f -> 1.0f inclusive
-  if (KeyInMap(kAlphaEncodingKey_ThumbSplay, input_map))
-    result.splay[0] = (std::stof(input_map.at(kAlphaEncodingKey_ThumbSplay)) / configuration_.max_analog_value - 0.5f) * 2.0f;
-  if (KeyInMap(kAlphaEncodingKey_IndexSplay, input_map))
-    result.splay[1] = (std::stof(input_map.at(kAlphaEncodingKey_IndexSplay)) / configuration_.max_analog_value - 0.5f) * 2.0f;
-  if (KeyInMap(kAlphaEncodingKey_MiddleSplay, input_map))
-    result.splay[2] = (std::stof(input_map.at(kAlphaEncodingKey_MiddleSplay)) / configuration_.max_analog_value - 0.5f) * 2.0f;
-  if (KeyInMap(kAlphaEncodingKey_RingSplay, input_map))
-    result.splay[3] = (std::stof(input_map.at(kAlphaEncodingKey_RingSplay)) / configuration_.max_analog_value - 0.5f) * 2.0f;
-  if (KeyInMap(kAlphaEncodingKey_PinkySplay, input_map))
-    result.splay[4] = (std::stof(input_map.at(kAlphaEncodingKey_PinkySplay)) / configuration_.max_analog_value - 0.5f) * 2.0f;
-
-  // main joystick
-  if (KeyInMap(kAlphaEncodingKey_MainJoystick_X, input_map))
-    result.joystick.x = 2 * std::stof(input_map.at(kAlphaEncodingKey_MainJoystick_X)) / configuration_.max_analog_value - 1;
-  if (KeyInMap(kAlphaEncodingKey_MainJoystick_Y, input_map))
-    result.joystick.y = 2 * std::stof(input_map.at(kAlphaEncodingKey_MainJoystick_Y)) / configuration_.max_analog_value - 1;
-
-  // trigger value: 0.0f -> 1.0f inclusive
-  if (KeyInMap(kAlphaEncodingKey_Trigger_Value, input_map))
-    result.trigger.value = std::stof(input_map.at(kAlphaEncodingKey_Trigger_Value)) / configuration_.max_analog_value;
-
-  result.joystick.pressed = KeyInMap(kAlphaEncodingKey_MainJoystick_Click, input_map);
-  result.trigger.pressed = KeyInMap(kAlphaEncodingKey_Trigger_Click, input_map);
-  result.A.pressed = KeyInMap(kAlphaEncodingKey_A_Click, input_map);
-  result.B.pressed = KeyInMap(kAlphaEncodingKey_B_Click, input_map);
-  result.grab.activated = KeyInMap(kAlphaEncodingKey_Grab_Gesture, input_map);
-  result.pinch.activated = KeyInMap(kAlphaEncodingKey_Pinch_Gesture, input_map);
-  result.menu.pressed = KeyInMap(kAlphaEncodingKey_Menu_Click, input_map);
-  result.calibrate.pressed = KeyInMap(kAlphaEncodingKey_Calibration_Click, input_map);
-
-  if (result == og::InputPeripheralData{}) throw std::runtime_error("Peripheral packet was empty.");
+  for (const auto& [key, scale, field] : alpha_encoding_analog_channels) {
+    if (!packet.Contains(key)) continue;
+
+    if (packet.values[key].status != og::kDecodeStatus_Ok) return packet.values[key].status;
+    const auto value = static_cast<float>(packet.values[key].integer);
+
+    switch (scale) {
+      case kAlphaEncodingAnalogScale_Unit:
+        field(out_data) = value / max_analog_value;
+        break;
+      case kAlphaEncodingAnalogScale_Splay:
+        field(out_data) = (value / max_analog_value - 0.5f) * 2.0f;
+        break;
+      case kAlphaEncodingAnalogScale_Joystick:
+        field(out_data) = 2 * value / max_analog_value - 1;
+        break;
+    }
+  }
 
-  return result;
+  for (const auto& [key, field] : alpha_encoding_digital_channels) {
+    field(out_data) = packet.Contains(key);
+  }
+
+  return og::kDecodeStatus_Ok;
+}
+
+// info values are integers that are cast to enums
+static og::DecodeStatus ParseInfoValue(const AlphaEncodingValue& value, int& out_value) {
+  if (value.status != og::kDecodeStatus_Ok) return value.status;
+  if (value.integer > static_cast<uint32_t>(std::numeric_limits<int>::max())) return og::kDecodeStatus_NumberOverflow;
+
+  out_value = static_cast<int>(value.integer);
+  return og::kDecodeStatus_Ok;
+}
+
+static og::DecodeStatus DecodeInfoPacket(const AlphaEncodingPacket& packet, og::InputInfoData& out_data) {
+  if ((packet.present & alpha_encoding_info_keys) == 0) return og::kDecodeStatus_Empty;
+
+  int value;
+  og::DecodeStatus status;
+
+  if (packet.Contains(kAlphaEncodingKey_Info_FWVersion)) {  // get firmware version
+    if ((status = ParseInfoValue(packet.values[kAlphaEncodingKey_Info_FWVersion], value)) != og::kDecodeStatus_Ok) return status;
+    out_data.firmware_version = value;
+  }
+  if (packet.Contains(kAlphaEncodingKey_Info_DeviceType)) {  // device type (ie. lucidgloves)
+    if ((status = ParseInfoValue(packet.values[kAlphaEncodingKey_Info_DeviceType], value)) != og::kDecodeStatus_Ok) return status;
+    out_data.device_type = static_cast<og::DeviceType>(value);
+  }
+  if (packet.Contains(kAlphaEncodingKey_Info_Hand)) {  // handedness (left/right)
+    if ((status = ParseInfoValue(packet.values[kAlphaEncodingKey_Info_Hand], value)) != og::kDecodeStatus_Ok) return status;
+    out_data.hand = static_cast<og::Hand>(value);
+  }
+  if (packet.Contains(kAlphaEncodingKey_Info_Encodings)) {  // supported encodings
+    if ((status = ParseInfoValue(packet.values[kAlphaEncodingKey_Info_Encodings], value)) != og::kDecodeStatus_Ok) return status;
+    out_data.supported_encodings = static_cast<uint32_t>(value);
+  }
+  if (packet.Contains(kAlphaEncodingKey_Info_AnalogResolution)) {  // analog resolution
+    if ((status = ParseInfoValue(packet.values[kAlphaEncodingKey_Info_AnalogResolution], value)) != og::kDecodeStatus_Ok) return status;
+    out_data.max_analog_resolution = value;
+  }
+
+  return og::kDecodeStatus_Ok;
+}
+
+static og::DecodeStatus DecodeScannedPacket(const AlphaEncodingPacket& packet, const float max_analog_value, og::Input& out_input) {
+  og::DecodeStatus status;
+  if (packet.Contains(kAlphaEncodingKey_Info)) {  // info packet
+    out_input.type = og::kInputDataType_Info;
+    out_input.data.info = {};
+    status = DecodeInfoPacket(packet, out_input.data.info);
+  } else {  // else try decode a peripheral packet (packet that encodes input data)
+    out_input.type = og::kInputDataType_Peripheral;
+    out_input.data.peripheral = {};
+    status = DecodePeripheralPacket(packet, max_analog_value, out_input.data.peripheral);
+  }
+
+  if (status != og::kDecodeStatus_Ok) {
+    out_input.type = og::kInputDataType_Invalid;
+    return status;
+  }
+
+  return packet.status;
+}
+
+class AlphaEncodingService::Impl {
+ public:
+  // partial packet carried over between calls to DecodeChunk
+  AlphaEncodingScanner stream_scanner;
+};
+
+AlphaEncodingService::AlphaEncodingService(const og::DeviceAlphaEncodingConfiguration& encoding_configuration)
+    : pImpl_(std::make_unique<Impl>()) {
+  configuration_ = encoding_configuration;
 }
 
-og::InputInfoData AlphaEncodingService::DecodeInfoPacket(const std::map<AlphaEncodingKey, std::string>& input_map) {
-  og::InputInfoData result{};
+og::DecodeStatus AlphaEncodingService::DecodePacket(std::string_view buff, og::Input& out_input) {
+  AlphaEncodingScanner scanner;
+
+  // newlines only end a packet when decoding a stream, a single packet is scanned all the way through
+  bool line_ended;
+  while (!buff.empty()) buff.remove_prefix(scanner.Scan(buff, line_ended));
+  scanner.Finish();
 
-  if (KeyInMap(kAlphaEncodingKey_Info_FWVersion, input_map))  // get firmware version
-    result.firmware_version = std::stoi(input_map.at(kAlphaEncodingKey_Info_FWVersion));
-  if (KeyInMap(kAlphaEncodingKey_Info_DeviceType, input_map))  // device type (ie. lucidgloves)
-    result.device_type = (og::DeviceType)std::stoi(input_map.at(kAlphaEncodingKey_Info_DeviceType));
-  if (KeyInMap(kAlphaEncodingKey_Info_Hand, input_map))  // handedness (left/right)
-    result.hand = (og::Hand)std::stoi(input_map.at(kAlphaEncodingKey_Info_Hand));
+  return DecodeScannedPacket(scanner.GetPacket(), static_cast<float>(configuration_.max_analog_value), out_input);
+}
+
+DecodeChunkResult AlphaEncodingService::DecodeChunk(
+    std::string_view chunk, std::span<og::Input> out_inputs, std::span<og::DecodeStatus> out_statuses) {
+  AlphaEncodingScanner& scanner = pImpl_->stream_scanner;
+  const size_t max_emitted = std::min(out_inputs.size(), out_statuses.size());
+
+  DecodeChunkResult result{};
+  while (result.consumed < chunk.length() && result.emitted < max_emitted) {
+    // the end of the packet is found up front (with simd where the cpu has it), so that the scanner only sees the packet itself
+    const std::string_view rest = chunk.substr(result.consumed);
+    const size_t newline = FindByte(rest.data(), rest.length(), '\n');
+
+    bool line_ended;
+    scanner.Scan(rest.substr(0, newline), line_ended);
+    if (newline == rest.length()) {
+      result.consumed = chunk.length();
+      break;
+    }
 
-  if (result == og::InputInfoData{}) throw std::runtime_error("Info packet was empty.");
+    result.consumed += newline + 1;
+    scanner.Finish();
+    out_statuses[result.emitted] =
+        DecodeScannedPacket(scanner.GetPacket(), static_cast<float>(configuration_.max_analog_value), out_inputs[result.emitted]);
+    result.emitted++;
+
+    scanner.Reset();
+  }
 
   return result;
 }
 
-og::Input AlphaEncodingService::DecodePacket(const std::string& buff) {
-  og::Input result{};
+void AlphaEncodingService::ResetChunkDecoder() {
+  pImpl_->stream_scanner.Reset();
+}
+
+AlphaEncodingService::~AlphaEncodingService() = default;
 
-  try {
-    std::map<AlphaEncodingKey, std::string> input_map = ParseToMap(buff);
+// Appends to a fixed buffer. Anything that does not fit marks the writer as overflowed, rather than being cut off.
+class AlphaEncodingWriter {
+ public:
+  explicit AlphaEncodingWriter(std::span<char> buff) : buff_(buff) {}
 
-    // info packet
-    if (input_map.contains(kAlphaEncodingKey_Info)) {
-      result.type = og::kInputDataType_Info;
-      result.data.info = DecodeInfoPacket(input_map);
-      return result;
+  void Append(std::string_view value) {
+    if (overflowed_ || value.length() > buff_.size() - length_) {
+      overflowed_ = true;
+      return;
     }
 
-    // else try decode a peripheral packet (packet that encodes
-    result.type = og::kInputDataType_Peripheral;
-    result.data.peripheral = DecodePeripheralPacket(input_map);
-    return result;
+    std::copy(value.begin(), value.end(), buff_.begin() + length_);
+    length_ += value.length();
+  }
 
-  } catch (const std::exception& ex) {
-    logger.Log(og::kLoggerLevel_Error, "Failed to parse data with alpha_encoding encoding: %s", ex.what());
-    logger.Log(og::kLoggerLevel_Info, "Packet that failed: %s", buff.c_str());
+  void AppendKey(const AlphaEncodingKey key) {
+    Append(alpha_encoding_output_key_strings[key]);
+  }
 
-    result.type = og::kInputDataType_Invalid;
-    return result;
+  void AppendInt(const int value) {
+    AppendResult(std::to_chars(buff_.data() + length_, buff_.data() + buff_.size(), value));
   }
-}
 
-template <typename... Args>
-static std::string StringFormat(const std::string& format, Args... args) {
-  const int sizeS = std::snprintf(nullptr, 0, format.c_str(), args...) + 1;  // Extra space for '\0'
+  // formatted like printf's %.<precision>f
+  void AppendFixed(const float value, const int precision) {
+    AppendResult(std::to_chars(buff_.data() + length_, buff_.data() + buff_.size(), static_cast<double>(value), std::chars_format::fixed, precision));
+  }
 
-  if (sizeS <= 0) {
-    logger.Log(og::kLoggerLevel_Error, "Error encoding output");
-    return "";
+  bool Finish(size_t& out_length) const {
+    out_length = overflowed_ ? 0 : length_;
+    return !overflowed_;
   }
 
-  const auto size = static_cast<size_t>(sizeS);
-  const auto buf = std::make_unique<char[]>(size);
-  std::snprintf(buf.get(), size, format.c_str(), args...);
+ private:
+  void AppendResult(const std::to_chars_result result) {
+    if (overflowed_ || result.ec != std::errc{}) {
+      overflowed_ = true;
+      return;
+    }
 
-  return std::string(buf.get(), buf.get() + size - 1);  // We don't want the '\0' inside
-}
+    length_ = result.ptr - buff_.data();
+  }
+
+  std::span<char> buff_;
+  size_t length_ = 0;
+  bool overflowed_ = false;
+};
+
+bool AlphaEncodingService::EncodePacket(const og::Output& output, std::span<char> buff, size_t& out_length) {
+  AlphaEncodingWriter writer(buff);
 
-std::string AlphaEncodingService::EncodePacket(const og::Output& output) {
   switch (output.type) {
     case og::kOutputDataType_FetchInfo: {
       const og::OutputFetchInfoData& data = output.data.fetch_info;
-      std::string result = "";
 
-      if (data.start_streaming) result += alpha_encoding_output_key_strings.at(kAlphaEncodingKey_Info_StartStreaming);
-      if (data.get_info) result += alpha_encoding_output_key_strings.at(kAlphaEncodingKey_Info);
+      if (data.start_streaming) writer.AppendKey(kAlphaEncodingKey_Info_StartStreaming);
+      if (data.get_info) writer.AppendKey(kAlphaEncodingKey_Info);
 
-      return result;
+      break;
     }
 
     case og::kOutputData_Type_ForceFeedback: {
       const og::OutputForceFeedbackData& data = output.data.force_feedback_data;
 
-      return StringFormat(
-          "%s%d%s%d%s%d%s%d%s%d\n",
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_ThumbCurl).c_str(),
-          data.thumb,
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_IndexCurl).c_str(),
-          data.index,
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_MiddleCurl).c_str(),
-          data.middle,
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_RingCurl).c_str(),
-          data.ring,
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_PinkyCurl).c_str(),
-          data.pinky);
+      writer.AppendKey(kAlphaEncodingKey_ThumbCurl);
+      writer.AppendInt(data.thumb);
+      writer.AppendKey(kAlphaEncodingKey_IndexCurl);
+      writer.AppendInt(data.index);
+      writer.AppendKey(kAlphaEncodingKey_MiddleCurl);
+      writer.AppendInt(data.middle);
+      writer.AppendKey(kAlphaEncodingKey_RingCurl);
+      writer.AppendInt(data.ring);
+      writer.AppendKey(kAlphaEncodingKey_PinkyCurl);
+      writer.AppendInt(data.pinky);
+      writer.Append("\n");
+
+      break;
     }
 
     case og::kOutputDataType_Haptic: {
       const og::OutputHapticData& data = output.data.haptic_data;
 
-      return StringFormat(
-          "%s%.2f%s%.2f%s%.2f\n",
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_OutHapticFrequency).c_str(),
-          data.frequency,
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_OutHapticDuration).c_str(),
-          data.duration,
-          alpha_encoding_output_key_strings.at(kAlphaEncodingKey_OutHapticAmplitude).c_str(),
-          data.amplitude);
+      writer.AppendKey(kAlphaEncodingKey_OutHapticFrequency);
+      writer.AppendFixed(data.frequency, 2);
+      writer.AppendKey(kAlphaEncodingKey_OutHapticDuration);
+      writer.AppendFixed(data.duration, 2);
+      writer.AppendKey(kAlphaEncodingKey_OutHapticAmplitude);
+      writer.AppendFixed(data.amplitude, 2);
+      writer.Append("\n");
+
+      break;
+    }
+
+    case og::kOutputDataType_Configure: {
+      const og::OutputConfigureData& data = output.data.configure;
+
+      writer.AppendKey(kAlphaEncodingKey_Info_Encodings);
+      writer.AppendInt(data.encoding);
+      writer.AppendKey(kAlphaEncodingKey_Info_AnalogResolution);
+      writer.AppendInt(data.analog_resolution);
+      writer.Append("\n");
+
+      break;
     }
 
     default:
       logger.Log(og::kLoggerLevel_Warning, "Unable to deduce output data type.");
+      [[fallthrough]];
+    // alpha packets always carry every value, so there is never a keyframe to ask for
+    case og::kOutputDataType_RequestKeyframe:
     case og::kOutputDataType_Empty: {
-      return "\n";
+      writer.Append("\n");
+      break;
     }
   }
-}
\ No newline at end of file
+
+  return writer.Finish(out_length);
+}
@@ -6,7 +6,9 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
+#include <span>
+#include <string_view>
 
 #include "communication/encoding/encoding_service.h"
 #include "opengloves_interface.h"
@@ -72,6 +74,8 @@ enum AlphaEncodingKey {
   kAlphaEncodingKey_Info_FWVersion,
   kAlphaEncodingKey_Info_DeviceType,
   kAlphaEncodingKey_Info_Hand,
+  kAlphaEncodingKey_Info_Encodings,
+  kAlphaEncodingKey_Info_AnalogResolution,
 
   kAlphaEncodingKey_Info_StartStreaming,
   kAlphaEncodingKey_Info_StopStreaming,
@@ -87,12 +91,17 @@ class AlphaEncodingService : public IEncodingService {
  public:
   AlphaEncodingService(const og::DeviceAlphaEncodingConfiguration& encoding_configuration);
 
-  og::Input DecodePacket(const std::string& buff) override;
-  std::string EncodePacket(const og::Output& output) override;
+  og::DecodeStatus DecodePacket(std::string_view buff, og::Input& out_input) override;
+  DecodeChunkResult DecodeChunk(std::string_view chunk, std::span<og::Input> out_inputs, std::span<og::DecodeStatus> out_statuses) override;
+  void ResetChunkDecoder() override;
+
+  bool EncodePacket(const og::Output& output, std::span<char> buff, size_t& out_length) override;
+
+  ~AlphaEncodingService() override;
 
  private:
-  og::InputPeripheralData DecodePeripheralPacket(const std::map<AlphaEncodingKey, std::string>& input_map);
-  og::InputInfoData DecodeInfoPacket(const std::map<AlphaEncodingKey, std::string>& input_map);
+  class Impl;
+  std::unique_ptr<Impl> pImpl_;
 
   og::DeviceAlphaEncodingConfiguration configuration_;
 };
\ No newline at end of file
@@ -0,0 +1,500 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "communication/encoding/binary_encoding_service.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "util/cobs.h"
+#include "util/crc16.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+static constexpr size_t binary_frame_header_length = 2;  // type, sequence
+static constexpr size_t binary_frame_crc_length = 2;
+
+static constexpr size_t binary_analog_channel_count = 28;
+
+// bytes taken by a run of 12 bit values, packed two to three bytes. An odd value out takes two
+static constexpr size_t GetPackedAnalogLength(const size_t count) {
+  return (count * 12 + 7) / 8;
+}
+
+static constexpr size_t binary_peripheral_body_length = GetPackedAnalogLength(binary_analog_channel_count) + 2;
+static constexpr size_t binary_delta_header_length = 6;  // changed channel mask, buttons
+static constexpr size_t binary_delta_max_body_length = binary_delta_header_length + GetPackedAnalogLength(binary_analog_channel_count);
+static constexpr size_t binary_info_body_length = 6;
+
+// a delta frame with every channel changed is the largest in either direction
+static constexpr size_t binary_max_frame_length =
+    binary_frame_header_length + std::max(binary_peripheral_body_length, binary_delta_max_body_length) + binary_frame_crc_length;
+
+// channels are always full scale, whatever resolution the device reports
+static constexpr float binary_max_analog_value = 4095.0f;
+
+enum BinaryEncodingAnalogScale {
+  kBinaryEncodingAnalogScale_Unit,    // 0.0f -> 1.0f inclusive
+  kBinaryEncodingAnalogScale_Signed,  // -1.0f -> 1.0f inclusive
+};
+
+// the scale of each analog channel, in the order they are packed
+static constexpr BinaryEncodingAnalogScale GetAnalogChannelScale(const size_t channel) {
+  return channel >= 20 && channel < 27 ? kBinaryEncodingAnalogScale_Signed : kBinaryEncodingAnalogScale_Unit;
+}
+
+static std::span<const uint8_t> AsBytes(std::string_view data) {
+  return {reinterpret_cast<const uint8_t*>(data.data()), data.size()};
+}
+
+static uint16_t ReadU16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static uint32_t ReadU32(const uint8_t* data) {
+  return ReadU16(data) | (static_cast<uint32_t>(ReadU16(data + 2)) << 16);
+}
+
+static og::DecodeStatus CheckBodyLength(const size_t length, const size_t expected) {
+  if (length < expected) return og::kDecodeStatus_Truncated;
+  if (length > expected) return og::kDecodeStatus_Malformed;
+
+  return og::kDecodeStatus_Ok;
+}
+
+// the values of the last keyframe, with every delta since applied. Shared by DecodePacket and DecodeChunk, as deltas can arrive either way
+struct BinaryEncodingDeltaState {
+  std::array<float, binary_analog_channel_count> channels{};
+  uint16_t buttons = 0;
+
+  // cleared when a frame is missed, until the next keyframe
+  bool base_valid = false;
+
+  bool has_sequence = false;
+  uint8_t last_sequence = 0;
+};
+
+// the index'th of a run of 12 bit values, packed two to three bytes
+static uint16_t ReadPackedAnalogValue(const uint8_t* data, const size_t index) {
+  const uint8_t* pair = data + index / 2 * 3;
+
+  return index % 2 == 0 ? static_cast<uint16_t>(pair[0] | ((pair[1] & 0x0F) << 8)) : static_cast<uint16_t>((pair[1] >> 4) | (pair[2] << 4));
+}
+
+static float ScaleAnalogValue(const uint16_t value, const size_t channel) {
+  const float unit = static_cast<float>(value) / binary_max_analog_value;
+
+  // the same scaling as the alpha encoding, so that switching encodings doesn't change the values
+  return GetAnalogChannelScale(channel) == kBinaryEncodingAnalogScale_Signed ? (unit - 0.5f) * 2.0f : unit;
+}
+
+static void ReadPeripheralData(const BinaryEncodingDeltaState& state, og::InputPeripheralData& out_data) {
+  const std::array<float, binary_analog_channel_count>& channels = state.channels;
+
+  for (size_t i = 0; i < 5; i++) {
+    for (size_t j = 0; j < 4; j++) out_data.flexion[i][j] = channels[i * 4 + j];
+    out_data.splay[i] = channels[20 + i];
+  }
+
+  out_data.joystick.x = channels[25];
+  out_data.joystick.y = channels[26];
+  out_data.trigger.value = channels[27];
+
+  const uint16_t buttons = state.buttons;
+  out_data.joystick.pressed = buttons & kBinaryEncodingButton_JoystickClick;
+  out_data.trigger.pressed = buttons & kBinaryEncodingButton_TriggerClick;
+  out_data.A.pressed = buttons & kBinaryEncodingButton_AClick;
+  out_data.B.pressed = buttons & kBinaryEncodingButton_BClick;
+  out_data.grab.activated = buttons & kBinaryEncodingButton_GrabGesture;
+  out_data.pinch.activated = buttons & kBinaryEncodingButton_PinchGesture;
+  out_data.menu.pressed = buttons & kBinaryEncodingButton_MenuClick;
+  out_data.calibrate.pressed = buttons & kBinaryEncodingButton_CalibrationClick;
+}
+
+static og::DecodeStatus DecodeDeltaBody(const uint8_t* body, const size_t body_length, BinaryEncodingDeltaState& state) {
+  if (body_length < binary_delta_header_length) return og::kDecodeStatus_Truncated;
+
+  const uint32_t changed = ReadU32(body);
+  if (changed >> binary_analog_channel_count != 0) return og::kDecodeStatus_Malformed;
+
+  const size_t changed_count = std::popcount(changed);
+
+  og::DecodeStatus status;
+  if ((status = CheckBodyLength(body_length, binary_delta_header_length + GetPackedAnalogLength(changed_count))) != og::kDecodeStatus_Ok)
+    return status;
+
+  if (!state.base_valid) return og::kDecodeStatus_Desynchronised;
+
+  const uint8_t* values = body + binary_delta_header_length;
+  size_t index = 0;
+  for (uint32_t remaining = changed; remaining != 0; remaining &= remaining - 1) {
+    const auto channel = static_cast<size_t>(std::countr_zero(remaining));
+    state.channels[channel] = ScaleAnalogValue(ReadPackedAnalogValue(values, index++), channel);
+  }
+  state.buttons = ReadU16(body + 4);
+
+  return og::kDecodeStatus_Ok;
+}
+
+// frame is a whole frame after cobs decoding
+static og::DecodeStatus DecodeFrame(std::span<const uint8_t> frame, BinaryEncodingDeltaState& state, og::Input& out_input) {
+  out_input.type = og::kInputDataType_Invalid;
+
+  if (frame.size() < binary_frame_header_length + binary_frame_crc_length) return og::kDecodeStatus_Truncated;
+
+  const size_t crc_offset = frame.size() - binary_frame_crc_length;
+  if (Crc16(frame.first(crc_offset)) != ReadU16(frame.data() + crc_offset)) return og::kDecodeStatus_ChecksumMismatch;
+
+  // a gap in the sequence means a frame was lost, and deltas can't be trusted until the next keyframe
+  const uint8_t sequence = frame[1];
+  if (state.has_sequence && sequence != static_cast<uint8_t>(state.last_sequence + 1)) state.base_valid = false;
+  state.has_sequence = true;
+  state.last_sequence = sequence;
+
+  const uint8_t* body = frame.data() + binary_frame_header_length;
+  const size_t body_length = crc_offset - binary_frame_header_length;
+
+  og::DecodeStatus status;
+  switch (frame[0]) {
+    case kBinaryEncodingFrameType_Peripheral: {
+      if ((status = CheckBodyLength(body_length, binary_peripheral_body_length)) != og::kDecodeStatus_Ok) return status;
+
+      for (size_t i = 0; i < binary_analog_channel_count; i += 2) {
+        state.channels[i] = ScaleAnalogValue(ReadPackedAnalogValue(body, i), i);
+        state.channels[i + 1] = ScaleAnalogValue(ReadPackedAnalogValue(body, i + 1), i + 1);
+      }
+      state.buttons = ReadU16(body + GetPackedAnalogLength(binary_analog_channel_count));
+      state.base_valid = true;
+
+      break;
+    }
+
+    case kBinaryEncodingFrameType_PeripheralDelta: {
+      if ((status = DecodeDeltaBody(body, body_length, state)) != og::kDecodeStatus_Ok) return status;
+
+      break;
+    }
+
+    case kBinaryEncodingFrameType_Info: {
+      if ((status = CheckBodyLength(body_length, binary_info_body_length)) != og::kDecodeStatus_Ok) return status;
+
+      out_input.data.info = {
+          .hand = static_cast<og::Hand>(body[3]),
+          .device_type = static_cast<og::DeviceType>(body[2]),
+          .firmware_version = ReadU16(body),
+          .supported_encodings = body[4],
+          .max_analog_resolution = body[5],
+      };
+      out_input.type = og::kInputDataType_Info;
+
+      return og::kDecodeStatus_Ok;
+    }
+
+    default:
+      return og::kDecodeStatus_UnknownKey;
+  }
+
+  // either kind of peripheral frame leaves every value in the state
+  out_input.data.peripheral = {};
+  ReadPeripheralData(state, out_input.data.peripheral);
+  out_input.type = og::kInputDataType_Peripheral;
+
+  return og::kDecodeStatus_Ok;
+}
+
+static og::DecodeStatus DecodeCobsFrame(
+    const CobsStreamDecoder& decoder, const CobsStreamDecoder::FrameStatus frame_status, BinaryEncodingDeltaState& state, og::Input& out_input) {
+  switch (frame_status) {
+    case CobsStreamDecoder::kFrameStatus_Ok:
+      return DecodeFrame(decoder.GetFrame(), state, out_input);
+
+    case CobsStreamDecoder::kFrameStatus_Empty:
+      out_input.type = og::kInputDataType_Invalid;
+      return og::kDecodeStatus_Empty;
+
+    default:
+      out_input.type = og::kInputDataType_Invalid;
+      return og::kDecodeStatus_Malformed;
+  }
+}
+
+// Builds a raw frame, then cobs encodes it into the output buffer. Anything that does not fit marks the writer as overflowed.
+class BinaryEncodingWriter {
+ public:
+  BinaryEncodingWriter(const BinaryEncodingFrameType type, const uint8_t sequence) {
+    AppendU8(type);
+    AppendU8(sequence);
+  }
+
+  void AppendU8(const uint8_t value) {
+    if (length_ == frame_.size()) {
+      overflowed_ = true;
+      return;
+    }
+
+    frame_[length_++] = value;
+  }
+
+  void AppendU16(const uint16_t value) {
+    AppendU8(static_cast<uint8_t>(value));
+    AppendU8(static_cast<uint8_t>(value >> 8));
+  }
+
+  void AppendU32(const uint32_t value) {
+    AppendU16(static_cast<uint16_t>(value));
+    AppendU16(static_cast<uint16_t>(value >> 16));
+  }
+
+  // 12 bit values, packed two to three bytes
+  void AppendPackedAnalog(std::span<const uint16_t> values) {
+    for (size_t i = 0; i + 1 < values.size(); i += 2) {
+      AppendU8(static_cast<uint8_t>(values[i]));
+      AppendU8(static_cast<uint8_t>((values[i] >> 8) | (values[i + 1] << 4)));
+      AppendU8(static_cast<uint8_t>(values[i + 1] >> 4));
+    }
+
+    if (values.size() % 2 != 0) AppendU16(values.back());
+  }
+
+  void AppendFloat(const float value) {
+    AppendU32(std::bit_cast<uint32_t>(value));
+  }
+
+  bool Finish(std::span<char> buff, size_t& out_length) {
+    out_length = 0;
+    if (overflowed_) return false;
+
+    const uint16_t crc = Crc16(std::span(frame_).first(length_));
+    AppendU16(crc);
+    if (overflowed_) return false;
+
+    const std::span<uint8_t> out(reinterpret_cast<uint8_t*>(buff.data()), buff.size());
+
+    size_t encoded_length;
+    if (!CobsEncode(std::span(frame_).first(length_), out, encoded_length) || encoded_length == out.size()) return false;
+
+    out[encoded_length++] = 0;
+    out_length = encoded_length;
+
+    return true;
+  }
+
+ private:
+  std::array<uint8_t, binary_max_frame_length> frame_;
+  size_t length_ = 0;
+  bool overflowed_ = false;
+};
+
+class BinaryEncodingService::Impl {
+ public:
+  Impl() : stream_decoder(stream_frame) {}
+
+  // partial frame carried over between calls to DecodeChunk
+  std::array<uint8_t, binary_max_frame_length> stream_frame{};
+  CobsStreamDecoder stream_decoder;
+
+  BinaryEncodingDeltaState delta_state;
+
+  uint8_t output_sequence = 0;
+};
+
+BinaryEncodingService::BinaryEncodingService() : pImpl_(std::make_unique<Impl>()) {}
+
+og::DecodeStatus BinaryEncodingService::DecodePacket(std::string_view buff, og::Input& out_input) {
+  std::array<uint8_t, binary_max_frame_length> frame;
+  CobsStreamDecoder decoder(frame);
+
+  CobsStreamDecoder::FrameStatus frame_status;
+  const size_t used = decoder.Decode(AsBytes(buff), frame_status);
+
+  if (frame_status == CobsStreamDecoder::kFrameStatus_Incomplete) {
+    static constexpr uint8_t delimiter = 0;
+    decoder.Decode({&delimiter, 1}, frame_status);
+  } else if (used != buff.length()) {
+    // there was more after the delimiter, so this was not a single frame
+    out_input.type = og::kInputDataType_Invalid;
+    return og::kDecodeStatus_Malformed;
+  }
+
+  return DecodeCobsFrame(decoder, frame_status, pImpl_->delta_state, out_input);
+}
+
+DecodeChunkResult BinaryEncodingService::DecodeChunk(
+    std::string_view chunk, std::span<og::Input> out_inputs, std::span<og::DecodeStatus> out_statuses) {
+  CobsStreamDecoder& decoder = pImpl_->stream_decoder;
+  const std::span<const uint8_t> data = AsBytes(chunk);
+  const size_t max_emitted = std::min(out_inputs.size(), out_statuses.size());
+
+  DecodeChunkResult result{};
+  while (result.consumed < data.size() && result.emitted < max_emitted) {
+    CobsStreamDecoder::FrameStatus frame_status;
+    result.consumed += decoder.Decode(data.subspan(result.consumed), frame_status);
+
+    if (frame_status == CobsStreamDecoder::kFrameStatus_Incomplete) break;
+
+    // firmware may send extra delimiters (ie. on startup, to flush a partial frame), those are not packets
+    if (frame_status == CobsStreamDecoder::kFrameStatus_Empty) continue;
+
+    out_statuses[result.emitted] = DecodeCobsFrame(decoder, frame_status, pImpl_->delta_state, out_inputs[result.emitted]);
+    result.emitted++;
+  }
+
+  return result;
+}
+
+void BinaryEncodingService::ResetChunkDecoder() {
+  pImpl_->stream_decoder.Reset();
+  pImpl_->delta_state = {};
+}
+
+bool BinaryEncodingService::EncodePacket(const og::Output& output, std::span<char> buff, size_t& out_length) {
+  switch (output.type) {
+    case og::kOutputDataType_FetchInfo: {
+      const og::OutputFetchInfoData& data = output.data.fetch_info;
+
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_FetchInfo, pImpl_->output_sequence++);
+      writer.AppendU8(
+          (data.start_streaming ? kBinaryEncodingFetchInfoFlag_StartStreaming : 0) | (data.get_info ? kBinaryEncodingFetchInfoFlag_GetInfo : 0));
+
+      return writer.Finish(buff, out_length);
+    }
+
+    case og::kOutputData_Type_ForceFeedback: {
+      const og::OutputForceFeedbackData& data = output.data.force_feedback_data;
+
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_ForceFeedback, pImpl_->output_sequence++);
+      for (const int16_t value : {data.thumb, data.index, data.middle, data.ring, data.pinky}) writer.AppendU16(static_cast<uint16_t>(value));
+
+      return writer.Finish(buff, out_length);
+    }
+
+    case og::kOutputDataType_Haptic: {
+      const og::OutputHapticData& data = output.data.haptic_data;
+
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_Haptic, pImpl_->output_sequence++);
+      writer.AppendFloat(data.frequency);
+      writer.AppendFloat(data.duration);
+      writer.AppendFloat(data.amplitude);
+
+      return writer.Finish(buff, out_length);
+    }
+
+    case og::kOutputDataType_Configure: {
+      const og::OutputConfigureData& data = output.data.configure;
+
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_Configure, pImpl_->output_sequence++);
+      writer.AppendU8(static_cast<uint8_t>(data.encoding));
+      writer.AppendU8(static_cast<uint8_t>(data.analog_resolution));
+
+      return writer.Finish(buff, out_length);
+    }
+
+    case og::kOutputDataType_RequestKeyframe: {
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_RequestKeyframe, pImpl_->output_sequence++);
+
+      return writer.Finish(buff, out_length);
+    }
+
+    default:
+      logger.Log(og::kLoggerLevel_Warning, "Unable to deduce output data type.");
+      [[fallthrough]];
+    case og::kOutputDataType_Empty:
+      out_length = 0;
+      return true;
+  }
+}
+
+// quantises a value back to the 12 bits it was decoded from
+static uint16_t EncodeAnalogValue(const float value, const BinaryEncodingAnalogScale scale) {
+  const float unit = scale == kBinaryEncodingAnalogScale_Signed ? value / 2.0f + 0.5f : value;
+
+  return static_cast<uint16_t>(std::lround(std::clamp(unit, 0.0f, 1.0f) * binary_max_analog_value));
+}
+
+static std::array<uint16_t, binary_analog_channel_count> EncodeAnalogChannels(const og::InputPeripheralData& data) {
+  std::array<float, binary_analog_channel_count> channels;
+  for (size_t i = 0; i < 5; i++) {
+    for (size_t j = 0; j < 4; j++) channels[i * 4 + j] = data.flexion[i][j];
+    channels[20 + i] = data.splay[i];
+  }
+  channels[25] = data.joystick.x;
+  channels[26] = data.joystick.y;
+  channels[27] = data.trigger.value;
+
+  std::array<uint16_t, binary_analog_channel_count> result;
+  for (size_t i = 0; i < binary_analog_channel_count; i++) result[i] = EncodeAnalogValue(channels[i], GetAnalogChannelScale(i));
+
+  return result;
+}
+
+static uint16_t EncodeButtons(const og::InputPeripheralData& data) {
+  return (data.joystick.pressed ? kBinaryEncodingButton_JoystickClick : 0) | (data.trigger.pressed ? kBinaryEncodingButton_TriggerClick : 0) |
+         (data.A.pressed ? kBinaryEncodingButton_AClick : 0) | (data.B.pressed ? kBinaryEncodingButton_BClick : 0) |
+         (data.grab.activated ? kBinaryEncodingButton_GrabGesture : 0) | (data.pinch.activated ? kBinaryEncodingButton_PinchGesture : 0) |
+         (data.menu.pressed ? kBinaryEncodingButton_MenuClick : 0) | (data.calibrate.pressed ? kBinaryEncodingButton_CalibrationClick : 0);
+}
+
+bool BinaryEncodingService::EncodeInput(const og::Input& input, const uint8_t sequence, std::span<char> buff, size_t& out_length) {
+  switch (input.type) {
+    case og::kInputDataType_Peripheral: {
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_Peripheral, sequence);
+      writer.AppendPackedAnalog(EncodeAnalogChannels(input.data.peripheral));
+      writer.AppendU16(EncodeButtons(input.data.peripheral));
+
+      return writer.Finish(buff, out_length);
+    }
+
+    case og::kInputDataType_Info: {
+      const og::InputInfoData& data = input.data.info;
+
+      BinaryEncodingWriter writer(kBinaryEncodingFrameType_Info, sequence);
+      writer.AppendU16(static_cast<uint16_t>(data.firmware_version));
+      writer.AppendU8(static_cast<uint8_t>(data.device_type));
+      writer.AppendU8(static_cast<uint8_t>(data.hand));
+      writer.AppendU8(static_cast<uint8_t>(data.supported_encodings));
+      writer.AppendU8(static_cast<uint8_t>(data.max_analog_resolution));
+
+      return writer.Finish(buff, out_length);
+    }
+
+    default:
+      out_length = 0;
+      return false;
+  }
+}
+
+bool BinaryEncodingService::EncodeDelta(
+    const og::InputPeripheralData& previous,
+    const og::InputPeripheralData& current,
+    const uint8_t sequence,
+    std::span<char> buff,
+    size_t& out_length) {
+  // compared after quantising, so that changes too small to send don't count
+  const std::array<uint16_t, binary_analog_channel_count> previous_channels = EncodeAnalogChannels(previous);
+  const std::array<uint16_t, binary_analog_channel_count> current_channels = EncodeAnalogChannels(current);
+
+  uint32_t changed = 0;
+  std::array<uint16_t, binary_analog_channel_count> changed_values;
+  size_t changed_count = 0;
+  for (size_t i = 0; i < binary_analog_channel_count; i++) {
+    if (previous_channels[i] == current_channels[i]) continue;
+
+    changed |= 1u << i;
+    changed_values[changed_count++] = current_channels[i];
+  }
+
+  BinaryEncodingWriter writer(kBinaryEncodingFrameType_PeripheralDelta, sequence);
+  writer.AppendU32(changed);
+  writer.AppendU16(EncodeButtons(current));
+  writer.AppendPackedAnalog(std::span(changed_values).first(changed_count));
+
+  return writer.Finish(buff, out_length);
+}
+
+BinaryEncodingService::~BinaryEncodingService() = default;
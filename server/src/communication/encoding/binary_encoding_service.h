@@ -0,0 +1,107 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include "communication/encoding/encoding_service.h"
+#include "opengloves_interface.h"
+
+/**
+ * Fixed layout binary encoding, for firmware that would rather not format and parse text. Every frame is:
+ *
+ *   [type: u8][sequence: u8][body][crc16: u16]
+ *
+ * The crc is CRC-16/CCITT-FALSE over the type, sequence and body. The whole frame is cobs encoded and ended with a zero byte, so a receiver can
+ * always resynchronise at the next zero. Multi byte values are little endian.
+ *
+ * Device to server:
+ *  - kBinaryEncodingFrameType_Peripheral (44 byte body): 28 analog channels of 12 bits (0 -> 4095), packed two to three bytes (the first channel
+ *    in the low 12 bits), then a u16 button bitfield (BinaryEncodingButton). The channels are flexion[finger][joint] (20), splay[finger] (5),
+ *    joystick x, joystick y and the trigger value. Flexion and trigger scale to 0 -> 1, splay and joystick to -1 -> 1.
+ *  - kBinaryEncodingFrameType_PeripheralDelta (6 to 48 byte body): u32 mask of the channels that changed since the last frame (bit n for channel
+ *    n), the u16 button bitfield, then the value of each changed channel in channel order, packed as in a peripheral frame (an odd value out takes
+ *    two bytes). The values are applied to the last peripheral frame (the keyframe). How often to send a keyframe is up to the device.
+ *  - kBinaryEncodingFrameType_Info (6 byte body): u16 firmware version, u8 device type, u8 hand, u8 supported encodings (bitfield of
+ *    1 << og::EncodingType), u8 highest analog resolution in bits.
+ *
+ * Server to device:
+ *  - kBinaryEncodingFrameType_ForceFeedback (10 byte body): i16 thumb, index, middle, ring, pinky.
+ *  - kBinaryEncodingFrameType_Haptic (12 byte body): f32 frequency, duration, amplitude.
+ *  - kBinaryEncodingFrameType_FetchInfo (1 byte body): BinaryEncodingFetchInfoFlag bitfield.
+ *  - kBinaryEncodingFrameType_Configure (2 byte body): u8 encoding to switch to (og::EncodingType), u8 analog resolution in bits. The resolution
+ *    only applies to text encodings, and is always 0 when switching to this one.
+ *  - kBinaryEncodingFrameType_RequestKeyframe (empty body): send a peripheral frame next.
+ *
+ * Input frames are numbered one after the other. Once a number is skipped, delta frames decode as og::kDecodeStatus_Desynchronised until the
+ * next keyframe, as the changes they would have been applied to were lost.
+ *
+ * Analog channels are always full scale 12 bits, whatever resolution the device reports. A device whose readings are wider or narrower scales
+ * them to 0 -> 4095 itself, and configuration.max_analog_value is not used.
+ *
+ * A peripheral frame is 50 bytes on the wire, compared to ~230 for an alpha packet with every joint. A delta frame with a couple of changed
+ * channels is 15.
+ */
+
+enum BinaryEncodingFrameType {
+  kBinaryEncodingFrameType_Peripheral = 0x01,
+  kBinaryEncodingFrameType_Info = 0x02,
+  kBinaryEncodingFrameType_PeripheralDelta = 0x03,
+
+  kBinaryEncodingFrameType_ForceFeedback = 0x81,
+  kBinaryEncodingFrameType_Haptic = 0x82,
+  kBinaryEncodingFrameType_FetchInfo = 0x83,
+  kBinaryEncodingFrameType_Configure = 0x84,
+  kBinaryEncodingFrameType_RequestKeyframe = 0x85,
+};
+
+enum BinaryEncodingButton {
+  kBinaryEncodingButton_JoystickClick = 1 << 0,
+  kBinaryEncodingButton_TriggerClick = 1 << 1,
+  kBinaryEncodingButton_AClick = 1 << 2,
+  kBinaryEncodingButton_BClick = 1 << 3,
+  kBinaryEncodingButton_GrabGesture = 1 << 4,
+  kBinaryEncodingButton_PinchGesture = 1 << 5,
+  kBinaryEncodingButton_MenuClick = 1 << 6,
+  kBinaryEncodingButton_CalibrationClick = 1 << 7,
+};
+
+enum BinaryEncodingFetchInfoFlag {
+  kBinaryEncodingFetchInfoFlag_StartStreaming = 1 << 0,
+  kBinaryEncodingFetchInfoFlag_GetInfo = 1 << 1,
+};
+
+class BinaryEncodingService : public IEncodingService {
+ public:
+  BinaryEncodingService();
+
+  // buff is a single cobs encoded frame, the trailing zero is optional. Delta frames are applied to the same values as in DecodeChunk
+  og::DecodeStatus DecodePacket(std::string_view buff, og::Input& out_input) override;
+  DecodeChunkResult DecodeChunk(std::string_view chunk, std::span<og::Input> out_inputs, std::span<og::DecodeStatus> out_statuses) override;
+  void ResetChunkDecoder() override;
+
+  // empty outputs encode to nothing, the device does not need a reply to keep streaming
+  bool EncodePacket(const og::Output& output, std::span<char> buff, size_t& out_length) override;
+
+  /**
+   * The device side of the encoding, to generate frames for benchmarks and tools that replay or simulate a device.
+   * Only kInputDataType_Peripheral and kInputDataType_Info inputs can be encoded.
+   */
+  static bool EncodeInput(const og::Input& input, uint8_t sequence, std::span<char> buff, size_t& out_length);
+
+  // a delta frame with the channels that changed from previous to current, as they would be decoded
+  static bool EncodeDelta(
+      const og::InputPeripheralData& previous, const og::InputPeripheralData& current, uint8_t sequence, std::span<char> buff, size_t& out_length);
+
+  ~BinaryEncodingService() override;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
@@ -0,0 +1,24 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "communication/encoding/encoding_service.h"
+
+#include "communication/encoding/alpha_encoding_service.h"
+#include "communication/encoding/binary_encoding_service.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+std::unique_ptr<IEncodingService> CreateEncodingService(og::EncodingType type, const og::DeviceAlphaEncodingConfiguration& alpha_configuration) {
+  switch (type) {
+    default:
+      logger.Log(og::kLoggerLevel_Warning, "Unknown or unset encoding type. Using alpha encoding.");
+      [[fallthrough]];
+    case og::kEncodingType_Alpha:
+      return std::make_unique<AlphaEncodingService>(alpha_configuration);
+    case og::kEncodingType_Binary:
+      return std::make_unique<BinaryEncodingService>();
+  }
+}
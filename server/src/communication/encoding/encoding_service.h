@@ -6,12 +6,38 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
 #include "opengloves_interface.h"
 
+struct DecodeChunkResult {
+  size_t consumed;  // bytes of the chunk that were used
+  size_t emitted;   // number of inputs (and statuses) written
+};
+
 class IEncodingService {
  public:
-  virtual og::Input DecodePacket(const std::string& buff) = 0;
-  virtual std::string EncodePacket(const og::Output& output) = 0;
+  // decodes a single packet. out_input.type is set to kInputDataType_Invalid if the status means the packet could not be used
+  virtual og::DecodeStatus DecodePacket(std::string_view buff, og::Input& out_input) = 0;
+
+  /**
+   * Decodes packets from an arbitrary piece of a stream, ie. whatever a read returned. A packet that is cut off at the end of the chunk is kept
+   * and completed by the next call. Every packet emits an input and its status, including invalid ones.
+   * Stops early once out_inputs or out_statuses is full, in which case the rest of the chunk (from consumed) should be passed again.
+   */
+  virtual DecodeChunkResult DecodeChunk(std::string_view chunk, std::span<og::Input> out_inputs, std::span<og::DecodeStatus> out_statuses) = 0;
+
+  // drops any partial packet kept by DecodeChunk, ie. after reconnecting
+  virtual void ResetChunkDecoder() = 0;
+  // encodes output into buff without allocating. Returns false (with out_length 0) if it did not fit
+  virtual bool EncodePacket(const og::Output& output, std::span<char> buff, size_t& out_length) = 0;
 
   virtual ~IEncodingService() = default;
-};
\ No newline at end of file
+};
+
+// creates the service for an encoding. alpha_configuration is only used by the alpha encoding
+std::unique_ptr<IEncodingService> CreateEncodingService(og::EncodingType type, const og::DeviceAlphaEncodingConfiguration& alpha_configuration);
\ No newline at end of file
@@ -12,7 +12,12 @@ class ICommunicationManager {
  public:
   virtual void BeginListener(std::function<void(const og::Input&)> callback) = 0;
 
+  // called when the link to the device is lost or restored. Must be called before BeginListener
+  virtual void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) = 0;
+
   virtual void WriteOutput(const og::Output& output) = 0;
 
+  virtual og::DeviceStatistics GetStatistics() = 0;
+
   virtual ~ICommunicationManager() = default;
 };
\ No newline at end of file
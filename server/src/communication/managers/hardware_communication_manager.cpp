@@ -6,16 +6,179 @@
 
 #include "hardware_communication_manager.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <span>
+#include <string_view>
+
 using namespace og;
 
 static Logger& logger = Logger::GetInstance();
 
+static const char* GetDecodeStatusDescription(DecodeStatus status) {
+  switch (status) {
+    case kDecodeStatus_Ok:
+      return "ok";
+    case kDecodeStatus_Empty:
+      return "the packet was empty";
+    case kDecodeStatus_UnknownKey:
+      return "the packet contained an unknown key";
+    case kDecodeStatus_MissingValue:
+      return "a key was missing its value";
+    case kDecodeStatus_NumberOverflow:
+      return "a value was out of range";
+    case kDecodeStatus_Truncated:
+      return "the packet was cut off";
+    case kDecodeStatus_ChecksumMismatch:
+      return "the packet failed its checksum";
+    case kDecodeStatus_Malformed:
+      return "the packet was not framed correctly";
+    case kDecodeStatus_Desynchronised:
+      return "a packet was lost, changes are dropped until the device sends all of its values";
+    default:
+      return "unknown";
+  }
+}
+
+static constexpr auto handshake_timeout = std::chrono::milliseconds(3000);
+// devices that reset when their port is opened miss requests sent while they boot, so the request is repeated until they reply
+static constexpr auto handshake_retry_interval = std::chrono::milliseconds(500);
+
+// every delta frame until the keyframe arrives is desynchronised, one request per round trip is enough
+static constexpr auto keyframe_request_interval = std::chrono::milliseconds(100);
+
+// a device streams continuously, so one that hasn't sent a packet for this long has stalled and is reconnected
+static constexpr auto stall_timeout = std::chrono::milliseconds(2000);
+
+// time between attempts to reconnect, doubled after every failed attempt up to the maximum
+static constexpr auto reconnect_backoff_min = std::chrono::milliseconds(250);
+static constexpr auto reconnect_backoff_max = std::chrono::milliseconds(8000);
+
+// big enough to take everything the transport has buffered after a burst in one read
+static constexpr size_t receive_buffer_length = 4096;
+
+// outputs written outside of the queue (ie. during the handshake) are small control packets
+static constexpr size_t max_immediate_write_length = 64;
+
+// encodings in order of preference, the fastest to decode and smallest on the wire first
+static constexpr std::array<EncodingType, 2> encoding_preference = {kEncodingType_Binary, kEncodingType_Alpha};
+
+// highest analog resolution each encoding can be asked to carry, in bits. Binary channels are always 12 bits at full scale, so there is none
+// to agree on and the device is left to scale its readings to fit
+static int GetMaxAnalogResolution(const EncodingType type) {
+  switch (type) {
+    case kEncodingType_Binary:
+      return 0;
+    default:
+      return 16;
+  }
+}
+
 HardwareCommunicationManager::HardwareCommunicationManager(
     std::unique_ptr<ICommunicationService> communication_service, std::unique_ptr<IEncodingService> encoding_service) {
   communication_service_ = std::move(communication_service);
   encoding_service_ = std::move(encoding_service);
 }
 
+bool HardwareCommunicationManager::Handshake(DeviceCommunicationConfiguration& configuration, InputInfoData& out_info) {
+  if (thread_active_) {
+    logger.Log(kLoggerLevel_Warning, "Did not start handshake as the communication listener was already active.");
+    return false;
+  }
+
+  configured_communication_ = configuration;
+
+  handshake_done_ = Negotiate(configuration, out_info);
+  if (handshake_done_) agreed_communication_ = configuration;
+
+  return handshake_done_;
+}
+
+bool HardwareCommunicationManager::Negotiate(DeviceCommunicationConfiguration& configuration, InputInfoData& out_info) {
+  // reads give up once their deadline passes, so a device that stays silent can't hold this past the handshake's own deadline
+  const bool received_info = ReceiveInfo(std::chrono::steady_clock::now() + handshake_timeout, out_info);
+
+  // anything left over was sent before the device knew what we wanted
+  encoding_service_->ResetChunkDecoder();
+
+  if (!received_info) {
+    logger.Log(kLoggerLevel_Warning, "Device did not reply with its info. Using the configured encoding and hand.");
+    return false;
+  }
+
+  logger.Log(
+      kLoggerLevel_Info,
+      "Device info: firmware version %i, %s hand, supported encodings %u, analog resolution %i bits",
+      out_info.firmware_version,
+      out_info.hand == kHandLeft ? "left" : "right",
+      out_info.supported_encodings,
+      out_info.max_analog_resolution);
+
+  // firmware that doesn't report its encodings only speaks the one it is already using
+  EncodingType encoding = configuration.encoding_type;
+  for (const EncodingType candidate : encoding_preference) {
+    if (out_info.supported_encodings & (1u << candidate)) {
+      encoding = candidate;
+      break;
+    }
+  }
+
+  // zero leaves the resolution as it is, ie. for binary or firmware that doesn't report it
+  const int analog_resolution = std::min(std::max(out_info.max_analog_resolution, 0), GetMaxAnalogResolution(encoding));
+
+  if (encoding != configuration.encoding_type || analog_resolution > 0) {
+    // sent in the encoding the device is using now, it switches once it has read this
+    const OutputConfigureData configure = {.encoding = encoding, .analog_resolution = analog_resolution};
+    if (!WriteNow({.type = kOutputDataType_Configure, .data = {.configure = configure}})) return false;
+
+    configuration.encoding_type = encoding;
+    if (analog_resolution > 0) configuration.encoding.max_analog_value = (1u << analog_resolution) - 1;
+
+    encoding_service_ = CreateEncodingService(configuration.encoding_type, configuration.encoding);
+
+    logger.Log(kLoggerLevel_Info, "Agreed on encoding %i with an analog resolution of %i bits", encoding, analog_resolution);
+  }
+
+  return WriteNow({.type = kOutputDataType_FetchInfo, .data = {.fetch_info = {.start_streaming = true, .get_info = false}}});
+}
+
+bool HardwareCommunicationManager::ReceiveInfo(const std::chrono::steady_clock::time_point deadline, InputInfoData& out_info) {
+  std::array<char, receive_buffer_length> receive_buffer{};
+  std::array<Input, 8> inputs{};
+  std::array<DecodeStatus, 8> statuses{};
+
+  std::chrono::steady_clock::time_point last_request{};
+  for (auto now = std::chrono::steady_clock::now(); now < deadline; now = std::chrono::steady_clock::now()) {
+    if (now - last_request >= handshake_retry_interval) {
+      if (!WriteNow({.type = kOutputDataType_FetchInfo, .data = {.fetch_info = {.start_streaming = false, .get_info = true}}})) return false;
+      last_request = now;
+    }
+
+    size_t bytes_read = 0;
+    if (!communication_service_->ReceiveNextChunk(receive_buffer, bytes_read)) return false;
+    link_statistics_.CountBytesRead(bytes_read);
+
+    std::string_view chunk(receive_buffer.data(), bytes_read);
+    while (!chunk.empty()) {
+      const DecodeChunkResult result = encoding_service_->DecodeChunk(chunk, inputs, statuses);
+      chunk.remove_prefix(result.consumed);
+
+      // older firmware may already be streaming, those packets are dropped until the handshake is done
+      for (size_t i = 0; i < result.emitted; i++) {
+        CountDecodeStatus(statuses[i], inputs[i]);
+
+        if (inputs[i].type == kInputDataType_Info) {
+          out_info = inputs[i].data.info;
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
 void HardwareCommunicationManager::BeginListener(std::function<void(const og::Input&)> callback) {
   if (thread_active_) {
     logger.Log(kLoggerLevel_Warning, "Did not start communication listener as the listener was already active.");
@@ -25,48 +188,309 @@ void HardwareCommunicationManager::BeginListener(std::function<void(const og::In
   callback_ = callback;
 
   thread_active_ = true;
+  link_connected_ = true;
 
   communication_thread_ = std::thread(&HardwareCommunicationManager::CommunicationThread, this);
+  writer_thread_ = std::thread(&HardwareCommunicationManager::WriterThread, this);
 }
 
 void HardwareCommunicationManager::CommunicationThread() {
+  std::array<char, receive_buffer_length> receive_buffer{};
+  std::array<Input, 8> inputs{};
+  std::array<DecodeStatus, 8> statuses{};
+
+  std::chrono::steady_clock::time_point last_keyframe_request{};
+  auto last_input = std::chrono::steady_clock::now();
+
   while (thread_active_) {
-    std::string received_string;
-    if (!communication_service_->ReceiveNextPacket(received_string)) {
+    size_t bytes_read = 0;
+    const bool read = communication_service_->ReceiveNextChunk(receive_buffer, bytes_read);
+
+    // the read was cancelled to stop the thread
+    if (!thread_active_) return;
+
+    // every packet in a read arrived together, as far as the server can tell
+    const auto received = std::chrono::steady_clock::now();
+
+    bool link_lost = true;
+    if (!read) {
       logger.Log(kLoggerLevel_Error, "Failed to read from device.");
+    } else if (received - last_input > stall_timeout) {
+      logger.Log(
+          kLoggerLevel_Warning,
+          "Device has not sent a valid packet for %lld ms.",
+          static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(received - last_input).count()));
+    } else {
+      // the writer thread has already logged why, if it failed
+      link_lost = !link_connected_;
+    }
+
+    if (link_lost) {
+      Reconnect();
 
-      return;
+      last_input = std::chrono::steady_clock::now();
+      last_keyframe_request = {};
+      continue;
     }
 
-    const Input input = encoding_service_->DecodePacket(received_string);
-    callback_(input);
+    link_statistics_.CountBytesRead(bytes_read);
+
+    // decode straight from what was read, packets that are cut off are completed by the next read
+    size_t packets_decoded = 0;
+    std::string_view chunk(receive_buffer.data(), bytes_read);
+    while (!chunk.empty()) {
+      const DecodeChunkResult result = encoding_service_->DecodeChunk(chunk, inputs, statuses);
+      chunk.remove_prefix(result.consumed);
+
+      for (size_t i = 0; i < result.emitted; i++) {
+        CountDecodeStatus(statuses[i], inputs[i]);
 
-    // now write information we might have
-    queued_write_string += "\n";
-    if (!communication_service_->RawWrite(queued_write_string)) {
-      logger.Log(kLoggerLevel_Error, "Failed to write to device.");
+        if (inputs[i].type == kInputDataType_Peripheral) link_statistics_.CountSample(received);
+        if (inputs[i].type != kInputDataType_Invalid) {
+          last_input = received;
+          callback_(inputs[i]);
+        }
 
-      return;
+        // the device only knows to send a keyframe early if asked, the request goes out with the reply to this read
+        if (statuses[i] == kDecodeStatus_Desynchronised && received - last_keyframe_request >= keyframe_request_interval) {
+          WriteOutput({.type = kOutputDataType_RequestKeyframe});
+          last_keyframe_request = received;
+        }
+      }
+
+      packets_decoded += result.emitted;
     }
-    if (queued_write_string != "\n")  // log any data we've sent to the device
-      logger.Log(kLoggerLevel_Info, "Wrote data to device: %s", queued_write_string.c_str());
 
-    queued_write_string.clear();
+    // the device expects a reply for packets it sent, not for every read
+    if (packets_decoded == 0) continue;
+
+    reply_pending_.store(true, std::memory_order_relaxed);
+    writer_signal_.fetch_add(1, std::memory_order_release);
+    writer_signal_.notify_one();
   }
 }
 
+void HardwareCommunicationManager::WriterThread() {
+  std::array<char, max_queued_write_length + max_reply_length> write_buffer;
+
+  while (thread_active_) {
+    const uint32_t signal = writer_signal_.load(std::memory_order_acquire);
+
+    for (QueuedOutput queued; output_queue_.TryPop(queued);) output_scheduler_.Push(queued.output, queued.queued);
+
+    const bool reply_pending = reply_pending_.exchange(false, std::memory_order_relaxed);
+
+    // outputs wait in the scheduler while the link is down, the communication thread signals once it has reconnected
+    if ((!output_scheduler_.HasPending() && !reply_pending) || !link_connected_) {
+      writer_signal_.wait(signal, std::memory_order_acquire);
+      continue;
+    }
+
+    // the communication thread may be swapping the encoding service while it reconnects
+    std::scoped_lock lock(link_mutex_);
+
+    // every write ends with the encoding's reply to a packet (a newline for alpha, nothing for binary), so that is left room for first
+    std::array<char, max_reply_length> reply;
+    size_t reply_length;
+    encoding_service_->EncodePacket({.type = kOutputDataType_Empty}, reply, reply_length);
+
+    const size_t write_budget = std::clamp(communication_service_->GetWriteBudget(), reply_length, write_buffer.size());
+
+    size_t write_length;
+    output_scheduler_.Pack(
+        *encoding_service_, std::chrono::steady_clock::now(), std::span(write_buffer).first(write_budget - reply_length), write_length);
+    std::copy_n(reply.begin(), reply_length, write_buffer.begin() + write_length);
+    write_length += reply_length;
+
+    if (write_length == 0) continue;
+
+    if (!communication_service_->RawWrite(std::string_view(write_buffer.data(), write_length))) {
+      OG_LOG_EVERY_MS_WITH(
+          write_log_limiter_,
+          log_rate_limit_ms,
+          kLoggerLevel_Error,
+          "Failed to write to device %s.",
+          communication_service_->GetIdentifier().c_str());
+      link_statistics_.CountWriteFailure();
+
+      // the outputs are written again once the communication thread has reconnected, if they are still worth writing by then
+      output_scheduler_.MarkFailed();
+      link_connected_ = false;
+      continue;
+    }
+    link_statistics_.CountBytesWritten(write_length);
+
+    output_scheduler_.MarkWritten(std::chrono::steady_clock::now());
+  }
+}
+
+void HardwareCommunicationManager::Reconnect() {
+  link_connected_ = false;
+  SetConnectionState(kDeviceConnectionState_Disconnected);
+
+  for (auto backoff = reconnect_backoff_min;;) {
+    {
+      std::unique_lock lock(reconnect_mutex_);
+      if (reconnect_condition_.wait_for(lock, backoff, [&] { return !thread_active_; })) return;
+    }
+
+    logger.Log(kLoggerLevel_Info, "Attempting to reconnect to device...");
+    {
+      std::scoped_lock lock(link_mutex_);
+      if (communication_service_->Reconnect() && Renegotiate()) break;
+    }
+
+    backoff = std::min(backoff * 2, reconnect_backoff_max);
+    logger.Log(kLoggerLevel_Warning, "Failed to reconnect to device, trying again in %lld ms", static_cast<long long>(backoff.count()));
+  }
+
+  logger.Log(kLoggerLevel_Info, "Reconnected to device");
+  link_statistics_.CountReconnect();
+
+  link_connected_ = true;
+  SetConnectionState(kDeviceConnectionState_Connected);
+
+  // outputs that were queued while the link was down
+  writer_signal_.fetch_add(1, std::memory_order_release);
+  writer_signal_.notify_one();
+}
+
+bool HardwareCommunicationManager::Renegotiate() {
+  // devices without the handshake start streaming again on their own
+  if (!handshake_done_) {
+    encoding_service_->ResetChunkDecoder();
+    return true;
+  }
+
+  // a device that only lost the link is still using the encoding that was agreed, one that was reset is back to the one it was configured with
+  for (const DeviceCommunicationConfiguration& candidate : {agreed_communication_, configured_communication_}) {
+    encoding_service_ = CreateEncodingService(candidate.encoding_type, candidate.encoding);
+
+    DeviceCommunicationConfiguration configuration = candidate;
+    InputInfoData info{};
+    if (Negotiate(configuration, info)) return true;
+
+    if (!thread_active_) return false;
+  }
+
+  return false;
+}
+
+void HardwareCommunicationManager::SetConnectionState(const DeviceConnectionState state) {
+  if (connection_state_callback_) connection_state_callback_(state);
+}
+
+void HardwareCommunicationManager::CountDecodeStatus(const DecodeStatus status, const Input& input) {
+  if (status != kDecodeStatus_Ok) link_statistics_.CountDecodeError();
+
+  decode_status_counts_[status].fetch_add(1, std::memory_order_relaxed);
+
+  // a noisy connection can fail to decode every packet
+  if (status != kDecodeStatus_Ok) {
+    OG_LOG_EVERY_MS_WITH(
+        decode_log_limiter_,
+        log_rate_limit_ms,
+        input.type == kInputDataType_Invalid ? kLoggerLevel_Error : kLoggerLevel_Warning,
+        "Problem decoding packet from device %s (%s)",
+        communication_service_->GetIdentifier().c_str(),
+        GetDecodeStatusDescription(status));
+  }
+}
+
+bool HardwareCommunicationManager::WriteNow(const og::Output& output) {
+  std::array<char, max_immediate_write_length + max_reply_length> buffer;
+  size_t encoded_length, reply_length;
+
+  // followed by the reply, the same as queued outputs are
+  if (!encoding_service_->EncodePacket(output, std::span(buffer).first(max_immediate_write_length), encoded_length) ||
+      !encoding_service_->EncodePacket({.type = kOutputDataType_Empty}, std::span(buffer).subspan(encoded_length), reply_length)) {
+    OG_LOG_EVERY_MS_WITH(
+        encode_log_limiter_,
+        log_rate_limit_ms,
+        kLoggerLevel_Error,
+        "Failed to encode output for device %s.",
+        communication_service_->GetIdentifier().c_str());
+    return false;
+  }
+
+  if (!communication_service_->RawWrite(std::string_view(buffer.data(), encoded_length + reply_length))) {
+    OG_LOG_EVERY_MS_WITH(
+        write_log_limiter_,
+        log_rate_limit_ms,
+        kLoggerLevel_Error,
+        "Failed to write to device %s.",
+        communication_service_->GetIdentifier().c_str());
+    link_statistics_.CountWriteFailure();
+    return false;
+  }
+  link_statistics_.CountBytesWritten(encoded_length + reply_length);
+
+  return true;
+}
+
 void HardwareCommunicationManager::WriteOutput(const og::Output& output) {
-  const std::string encoded_string = encoding_service_->EncodePacket(output);
-  queued_write_string += encoded_string;
+  if (output.type < 0 || output.type >= kOutputDataType_Max) {
+    OG_LOG_EVERY_MS(log_rate_limit_ms, kLoggerLevel_Warning, "Unable to deduce output data type.");
+    return;
+  }
+
+  output_scheduler_.CountQueued(output.type);
+  if (!output_queue_.TryPush({output, std::chrono::steady_clock::now()})) {
+    // a stalled device would otherwise flood the log
+    output_scheduler_.CountDropped(output.type);
+    OG_LOG_EVERY_MS_WITH(
+        dropped_output_log_limiter_,
+        log_rate_limit_ms,
+        kLoggerLevel_Warning,
+        "Dropped output to device %s as too many outputs are already waiting to be written.",
+        communication_service_->GetIdentifier().c_str());
+
+    return;
+  }
+
+  writer_signal_.fetch_add(1, std::memory_order_release);
+  writer_signal_.notify_one();
+}
+
+void HardwareCommunicationManager::ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+  connection_state_callback_ = std::move(callback);
+}
+
+og::DeviceStatistics HardwareCommunicationManager::GetStatistics() {
+  og::DeviceStatistics result{};
+
+  for (int i = 0; i < kDecodeStatus_Max; i++) {
+    result.decode.packets[i] = decode_status_counts_[i].load(std::memory_order_relaxed);
+  }
+
+  output_scheduler_.GetStatistics(result.write);
+  link_statistics_.GetStatistics(result.link);
+
+  const CommunicationServiceStatistics service_statistics = communication_service_->GetStatistics();
+  result.link.read_syscalls = service_statistics.read_syscalls;
+  result.link.write_syscalls = service_statistics.write_syscalls;
+  result.link.dropped_packets = service_statistics.dropped_packets;
+
+  return result;
 }
 
 HardwareCommunicationManager::~HardwareCommunicationManager() {
   if (thread_active_.exchange(false)) {
     communication_service_->PrepareDisconnect();
 
+    // stops the communication thread waiting to reconnect
+    {
+      std::scoped_lock lock(reconnect_mutex_);
+    }
+    reconnect_condition_.notify_one();
+
     logger.Log(kLoggerLevel_Info, "Attempting to cleanup communication thread...");
     communication_thread_.join();
 
+    writer_signal_.fetch_add(1, std::memory_order_release);
+    writer_signal_.notify_one();
+    writer_thread_.join();
+
     logger.Log(kLoggerLevel_Info, "Successfully cleaned up communication thread");
   }
 }
\ No newline at end of file
@@ -6,38 +6,116 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 #include "communication/encoding/encoding_service.h"
 #include "communication/services/communication_service.h"
 #include "communication_manager.h"
+#include "link_statistics.h"
+#include "output_scheduler.h"
+#include "util/mpsc_queue.h"
 
 /**
  * A communication manager that manages a resources that can be queried and writes to/from the device in strings using an encoding scheme. Ie.
  * Bluetooth, Serial, etc. But **NOT** ipc methods like named pipes.
+ *
+ * If a read or write fails, or the device stops sending valid packets, the link is reconnected in place (waiting longer between each attempt)
+ * and the handshake is done again.
  */
 class HardwareCommunicationManager : public ICommunicationManager {
  public:
   HardwareCommunicationManager(std::unique_ptr<ICommunicationService> communication_service, std::unique_ptr<IEncodingService> encoding_service);
 
+  /**
+   * Asks the device for its info, then agrees on the fastest encoding and analog resolution that both sides support before it starts streaming.
+   * Must be called before BeginListener. configuration is updated with what was agreed.
+   * Returns false if the device did not reply with its info in time (ie. older firmware), in which case the configured encoding is kept.
+   */
+  bool Handshake(og::DeviceCommunicationConfiguration& configuration, og::InputInfoData& out_info);
+
   void BeginListener(std::function<void(const og::Input&)> callback) override;
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) override;
 
+  /**
+   * Queues an output for the writer thread, which writes it straight away rather than waiting for the next packet from the device. If an output
+   * of the same type is still waiting to be written, it is replaced (see OutputScheduler). Safe to call from any thread.
+   */
   void WriteOutput(const og::Output& output) override;
 
+  og::DeviceStatistics GetStatistics() override;
+
   ~HardwareCommunicationManager() override;
 
  private:
   void CommunicationThread();
+  void WriterThread();
+
+  bool Negotiate(og::DeviceCommunicationConfiguration& configuration, og::InputInfoData& out_info);
+  bool ReceiveInfo(std::chrono::steady_clock::time_point deadline, og::InputInfoData& out_info);
+
+  // on the communication thread, returns once the link is back or the manager is being destroyed
+  void Reconnect();
+  // does the handshake again on a link that has just reconnected
+  bool Renegotiate();
+  void SetConnectionState(og::DeviceConnectionState state);
+  void CountDecodeStatus(og::DecodeStatus status, const og::Input& input);
+
+  // encodes and writes an output from the calling thread, for the handshake before the writer thread is started
+  bool WriteNow(const og::Output& output);
 
   std::atomic<bool> thread_active_;
   std::thread communication_thread_;
+  std::thread writer_thread_;
+
+  // false from a read or write to the device failing until the communication thread has reconnected
+  std::atomic<bool> link_connected_ = true;
+  // held by the writer thread while it writes, and the communication thread while it reconnects, so that the two don't use the link at once
+  std::mutex link_mutex_;
+  // wakes the communication thread from waiting between reconnect attempts
+  std::mutex reconnect_mutex_;
+  std::condition_variable reconnect_condition_;
+
+  // kept to do the handshake again after a reconnect
+  bool handshake_done_ = false;
+  og::DeviceCommunicationConfiguration configured_communication_{};
+  og::DeviceCommunicationConfiguration agreed_communication_{};
+
+  struct QueuedOutput {
+    og::Output output;
+    std::chrono::steady_clock::time_point queued;
+  };
+  MpscQueue<QueuedOutput, 64> output_queue_;
+  OutputScheduler output_scheduler_;
+
+  // set by the communication thread when the device sent packets, so that the writer replies to them
+  std::atomic<bool> reply_pending_ = false;
+  // bumped after every output is queued (or reply is needed), the writer thread waits on it changing
+  std::atomic<uint32_t> writer_signal_ = 0;
+
+  // outputs are packed into one buffer and written together, up to the transport's write budget
+  static constexpr size_t max_queued_write_length = 256;
+  // room for the reply to a packet that is written after the queued outputs
+  static constexpr size_t max_reply_length = 16;
+
+  std::array<std::atomic<uint64_t>, og::kDecodeStatus_Max> decode_status_counts_{};
+  LinkStatistics link_statistics_;
 
-  std::string queued_write_string;
+  // each device holds back its own errors, so that one failing doesn't hide another's
+  og::LogRateLimiter decode_log_limiter_;
+  og::LogRateLimiter encode_log_limiter_;
+  og::LogRateLimiter write_log_limiter_;
+  og::LogRateLimiter dropped_output_log_limiter_;
 
   std::function<void(const og::Input&)> callback_;
+  std::function<void(og::DeviceConnectionState)> connection_state_callback_;
 
   std::unique_ptr<ICommunicationService> communication_service_;
   std::unique_ptr<IEncodingService> encoding_service_;
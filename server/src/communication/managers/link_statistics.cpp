@@ -0,0 +1,152 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "link_statistics.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace og;
+
+static constexpr int64_t rate_window_ns = 1'000'000'000;
+
+static size_t GetGapBucket(const uint64_t gap_us) {
+  if (gap_us == 0) return 0;
+
+  return std::min(static_cast<size_t>(std::bit_width(gap_us) - 1), link_gap_histogram_buckets - 1);
+}
+
+// the gap below which the given fraction of gaps fall, assuming the gaps in a bucket are spread evenly across it
+static uint64_t GetGapPercentile(const std::array<uint64_t, link_gap_histogram_buckets>& histogram, const uint64_t total, const double fraction) {
+  if (total == 0) return 0;
+
+  const double target = fraction * static_cast<double>(total);
+  uint64_t below = 0;
+  for (size_t bucket = 0; bucket < histogram.size(); bucket++) {
+    if (histogram[bucket] == 0 || static_cast<double>(below + histogram[bucket]) < target) {
+      below += histogram[bucket];
+      continue;
+    }
+
+    const double lower = bucket == 0 ? 0.0 : static_cast<double>(uint64_t{1} << bucket);
+    const double upper = static_cast<double>(uint64_t{1} << (bucket + 1));
+
+    return static_cast<uint64_t>(lower + (upper - lower) * (target - static_cast<double>(below)) / static_cast<double>(histogram[bucket]));
+  }
+
+  return uint64_t{1} << link_gap_histogram_buckets;
+}
+
+void LinkStatistics::CountSample(const std::chrono::steady_clock::time_point arrived) {
+  const int64_t arrived_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(arrived.time_since_epoch()).count();
+
+  samples_.fetch_add(1, std::memory_order_relaxed);
+
+  // the first sample has nothing to be a gap from
+  const int64_t last_ns = last_sample_ns_.exchange(arrived_ns, std::memory_order_relaxed);
+  if (last_ns != 0 && arrived_ns >= last_ns) {
+    gap_histogram_[GetGapBucket(static_cast<uint64_t>(arrived_ns - last_ns) / 1000)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const uint64_t window_samples = rate_window_samples_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  int64_t window_start_ns = rate_window_start_ns_.load(std::memory_order_relaxed);
+  if (window_start_ns == 0) {
+    // the first sample starts the window, so isn't counted in it
+    if (rate_window_start_ns_.compare_exchange_strong(window_start_ns, arrived_ns, std::memory_order_relaxed)) {
+      rate_window_samples_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  const int64_t elapsed_ns = arrived_ns - window_start_ns;
+  if (elapsed_ns < rate_window_ns) return;
+
+  // only the caller that moves the window on publishes the rate, another may be counting a sample at the same time
+  if (!rate_window_start_ns_.compare_exchange_strong(window_start_ns, arrived_ns, std::memory_order_relaxed)) return;
+
+  rate_window_samples_.fetch_sub(window_samples, std::memory_order_relaxed);
+  samples_per_second_.store(static_cast<double>(window_samples) * 1e9 / static_cast<double>(elapsed_ns), std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountLatency(const std::chrono::steady_clock::duration latency) {
+  const auto latency_us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  if (latency_us < 0) return;
+
+  latency_histogram_[GetGapBucket(static_cast<uint64_t>(latency_us))].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountLostSamples(const uint64_t samples) {
+  lost_samples_.fetch_add(samples, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountBytesRead(const size_t bytes) {
+  bytes_read_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountBytesWritten(const size_t bytes) {
+  bytes_written_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountDecodeError() {
+  decode_errors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountWriteFailure() {
+  write_failures_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountReconnect() {
+  reconnects_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountClientConnected() {
+  client_connects_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LinkStatistics::CountClientDisconnected() {
+  client_disconnects_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LinkStatistics::GetStatistics(DeviceLinkStatistics& out_statistics) const {
+  out_statistics.samples = samples_.load(std::memory_order_relaxed);
+
+  // the rate is only published when a sample arrives, so it would otherwise stay where it was when the device went quiet
+  const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  const bool quiet = now_ns - last_sample_ns_.load(std::memory_order_relaxed) > rate_window_ns;
+  out_statistics.samples_per_second = quiet ? 0 : samples_per_second_.load(std::memory_order_relaxed);
+
+  uint64_t gaps = 0;
+  for (size_t bucket = 0; bucket < gap_histogram_.size(); bucket++) {
+    out_statistics.gap_histogram[bucket] = gap_histogram_[bucket].load(std::memory_order_relaxed);
+    gaps += out_statistics.gap_histogram[bucket];
+  }
+
+  out_statistics.gap_p50_us = GetGapPercentile(out_statistics.gap_histogram, gaps, 0.50);
+  out_statistics.gap_p99_us = GetGapPercentile(out_statistics.gap_histogram, gaps, 0.99);
+
+  uint64_t latencies = 0;
+  for (size_t bucket = 0; bucket < latency_histogram_.size(); bucket++) {
+    out_statistics.latency_histogram[bucket] = latency_histogram_[bucket].load(std::memory_order_relaxed);
+    latencies += out_statistics.latency_histogram[bucket];
+  }
+
+  out_statistics.latency_p50_us = GetGapPercentile(out_statistics.latency_histogram, latencies, 0.50);
+  out_statistics.latency_p99_us = GetGapPercentile(out_statistics.latency_histogram, latencies, 0.99);
+  out_statistics.lost_samples = lost_samples_.load(std::memory_order_relaxed);
+
+  out_statistics.bytes_read = bytes_read_.load(std::memory_order_relaxed);
+  out_statistics.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+
+  out_statistics.decode_errors = decode_errors_.load(std::memory_order_relaxed);
+  out_statistics.write_failures = write_failures_.load(std::memory_order_relaxed);
+  out_statistics.reconnects = reconnects_.load(std::memory_order_relaxed);
+
+  // disconnects first, so that a client connecting in between can't make it look like more went away than came
+  out_statistics.client_disconnects = client_disconnects_.load(std::memory_order_relaxed);
+  out_statistics.client_connects = client_connects_.load(std::memory_order_relaxed);
+  out_statistics.clients = out_statistics.client_connects - out_statistics.client_disconnects;
+}
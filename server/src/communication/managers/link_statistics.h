@@ -0,0 +1,66 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "opengloves_interface.h"
+
+/**
+ * Counters about the health of the link to a device: how regularly samples arrive, how many bytes go each way and how often reads, writes and
+ * the connection itself fail. Every function only touches atomics, so is cheap enough to call for each read and safe from any thread.
+ */
+class LinkStatistics {
+ public:
+  // a sample arrived from the device at the given time
+  void CountSample(std::chrono::steady_clock::time_point arrived);
+
+  // how long after the device took a sample it arrived, for transports whose samples say when they were taken
+  void CountLatency(std::chrono::steady_clock::duration latency);
+
+  // samples the device numbered but that never arrived
+  void CountLostSamples(uint64_t samples);
+
+  void CountBytesRead(size_t bytes);
+  void CountBytesWritten(size_t bytes);
+
+  void CountDecodeError();
+  void CountWriteFailure();
+  void CountReconnect();
+
+  // for transports that several clients can write to at once
+  void CountClientConnected();
+  void CountClientDisconnected();
+
+  void GetStatistics(og::DeviceLinkStatistics& out_statistics) const;
+
+ private:
+  std::atomic<uint64_t> samples_ = 0;
+  std::atomic<int64_t> last_sample_ns_ = 0;
+  std::array<std::atomic<uint64_t>, og::link_gap_histogram_buckets> gap_histogram_{};
+
+  // samples are counted over a second at a time, then the rate is published when the second is up
+  std::atomic<int64_t> rate_window_start_ns_ = 0;
+  std::atomic<uint64_t> rate_window_samples_ = 0;
+  std::atomic<double> samples_per_second_ = 0;
+
+  std::array<std::atomic<uint64_t>, og::link_gap_histogram_buckets> latency_histogram_{};
+  std::atomic<uint64_t> lost_samples_ = 0;
+
+  std::atomic<uint64_t> bytes_read_ = 0;
+  std::atomic<uint64_t> bytes_written_ = 0;
+
+  std::atomic<uint64_t> decode_errors_ = 0;
+  std::atomic<uint64_t> write_failures_ = 0;
+  std::atomic<uint64_t> reconnects_ = 0;
+
+  std::atomic<uint64_t> client_connects_ = 0;
+  std::atomic<uint64_t> client_disconnects_ = 0;
+};
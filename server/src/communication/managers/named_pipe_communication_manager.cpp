@@ -6,14 +6,21 @@
 
 #include "named_pipe_communication_manager.h"
 
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <regex>
 #include <utility>
 
-#include "named_pipe/named_pipe_win.h"
+#include "ipc/ipc_listener.h"
+#include "link_statistics.h"
 #include "opengloves_interface.h"
 
 static og::Logger& logger = og::Logger::GetInstance();
 
+// under priority arbitration, a client that hasn't sent anything for this long gives the hand up to the one that connected after it
+static constexpr auto named_pipe_priority_timeout = std::chrono::milliseconds(500);
+
 namespace NamedPipeInputDataVersion {
   struct v1 {
     const std::array<std::array<float, 4>, 5> flexion;
@@ -47,65 +54,104 @@ namespace NamedPipeInputDataVersion {
     // new
     float trigger_value;
   };
+
+  // a header followed by sample_count samples, each laid out as a v2 is, so that several samples can be sent in one write
+  struct v3_header {
+    uint32_t version;       // always 3
+    uint32_t sample_count;  // 1 to named_pipe_v3_max_samples
+    uint64_t sequence;      // of the first sample. The producer numbers every sample it takes, so a jump means some were never sent
+    int64_t timestamp_ns;   // the producer's steady clock (CLOCK_MONOTONIC, or QueryPerformanceCounter) when the last sample was taken
+  };
+
+  using v3_sample = v2;
 }  // namespace NamedPipeInputDataVersion
 
-struct NamedPipeInputData : public NamedPipeInputDataVersion::v2 {
-  NamedPipeInputData() : NamedPipeInputDataVersion::v2(){};
-
-  NamedPipeInputData(const NamedPipeInputDataVersion::v1& data) {
-    flexion = data.flexion;
-    splay = data.splay;
-    joy_x = data.joy_x;
-    joy_y = data.joy_y;
-    joy_button = data.joy_button;
-    trigger_button = data.trigger_button;
-    trigger_value = data.trigger_button;
-    a_button = data.a_button;
-    b_button = data.b_button;
-    grab = data.grab;
-    pinch = data.pinch;
-    menu = data.menu;
-    calibrate = data.calibrate;
-  }
+static constexpr uint32_t named_pipe_v3_version = 3;
+static constexpr uint32_t named_pipe_v3_max_samples = 16;
+static constexpr size_t named_pipe_v3_max_message_length =
+    sizeof(NamedPipeInputDataVersion::v3_header) + named_pipe_v3_max_samples * sizeof(NamedPipeInputDataVersion::v3_sample);
+
+static_assert(sizeof(NamedPipeInputDataVersion::v3_header) == 24, "the v3 header is part of the wire format");
+static_assert(sizeof(NamedPipeInputDataVersion::v3_sample) % alignof(NamedPipeInputDataVersion::v3_sample) == 0);
+
+// reads any version's sample straight from where it arrived, rather than through a copy in the newest version's layout
+template <typename T>
+static og::Input ToInput(const T& sample) {
+  og::Input result{};
+  result.type = og::kInputDataType_Peripheral;
+
+  og::InputPeripheralData& data = result.data.peripheral;
+
+  data.flexion = sample.flexion;
+  data.splay = sample.splay;
+
+  data.A.pressed = sample.a_button;
+  data.A.value = sample.a_button;
+
+  data.B.pressed = sample.b_button;
+  data.B.value = sample.b_button;
 
-  NamedPipeInputData(const NamedPipeInputDataVersion::v2& data) {
-    flexion = data.flexion;
-    splay = data.splay;
-    joy_x = data.joy_x;
-    joy_y = data.joy_y;
-    joy_button = data.joy_button;
-    trigger_button = data.trigger_button;
-    trigger_value = data.trigger_value;
-    a_button = data.a_button;
-    b_button = data.b_button;
-    grab = data.grab;
-    pinch = data.pinch;
-    menu = data.menu;
-    calibrate = data.calibrate;
-    trigger_value = data.trigger_value;
+  // v1 only has the button
+  data.trigger.pressed = sample.trigger_button;
+  if constexpr (requires { sample.trigger_value; }) {
+    data.trigger.value = sample.trigger_value;
+  } else {
+    data.trigger.value = sample.trigger_button;
   }
+
+  data.joystick.x = sample.joy_x;
+  data.joystick.y = sample.joy_y;
+  data.joystick.pressed = sample.joy_button;
+
+  data.calibrate.pressed = sample.calibrate;
+  data.calibrate.value = sample.calibrate;
+
+  data.grab.activated = sample.grab;
+  data.pinch.activated = sample.pinch;
+
+  data.menu.pressed = sample.menu;
+  data.menu.value = sample.menu;
+
+  return result;
+}
+
+// a client connected to any version of a hand's pipe
+struct NamedPipeClientSession {
+  bool has_sent = false;
+  std::chrono::steady_clock::time_point last_sample;
+
+  // the sequence the next v3 message should start at, once one has been seen
+  bool has_sequence = false;
+  uint64_t next_sequence = 0;
 };
 
 class NamedPipeCommunicationManager::Impl {
  public:
-  Impl(og::Hand hand, std::function<void()> on_client_connected_callback)
-      : hand_(hand), on_client_connected_callback_(std::move(on_client_connected_callback)){};
+  Impl(og::Hand hand, const og::NamedPipeCommunicationConfiguration& configuration, std::function<void()> on_client_connected_callback)
+      : hand_(hand), arbitration_(configuration.arbitration), on_client_connected_callback_(std::move(on_client_connected_callback)){};
 
-  void StartListener(std::function<void(const NamedPipeInputData&)> on_data_callback) {
+  void StartListener(std::function<void(const og::Input&)> on_data_callback) {
     on_data_callback_ = std::move(on_data_callback);
 
-    std::string base_name = R"(\\.\pipe\vrapplication\input\glove\$version\)" + std::string(hand_ == og::kHandLeft ? "left" : "right");
+    // \\.\pipe\vrapplication\input\glove\$version\<hand> on windows
+    std::string base_name = "vrapplication/input/glove/$version/" + std::string(hand_ == og::kHandLeft ? "left" : "right");
 
     // v1
-    named_pipes_.emplace_back(std::make_unique<NamedPipeListener<NamedPipeInputDataVersion::v1>>(
+    named_pipes_.emplace_back(std::make_unique<IpcListener<NamedPipeInputDataVersion::v1>>(
         std::regex_replace(base_name, std::regex("\\$version"), "v1"),
-        [&](const NamedPipeListenerEvent& event) { OnEvent(event); },
-        [&](NamedPipeInputDataVersion::v1* data) { on_data_callback_(static_cast<NamedPipeInputData>(*data)); }));
+        [&](const IpcListenerEvent& event) { OnEvent(event); },
+        [&](const uint64_t client, const NamedPipeInputDataVersion::v1* data) { OnData(client, *data); }));
     // v2
-    named_pipes_.emplace_back(std::make_unique<NamedPipeListener<NamedPipeInputDataVersion::v2>>(
+    named_pipes_.emplace_back(std::make_unique<IpcListener<NamedPipeInputDataVersion::v2>>(
         std::regex_replace(base_name, std::regex("\\$version"), "v2"),
-        [&](const NamedPipeListenerEvent& event) { OnEvent(event); },
-        [&](NamedPipeInputDataVersion::v2* data) { on_data_callback_(static_cast<NamedPipeInputData>(*data)); }));
+        [&](const IpcListenerEvent& event) { OnEvent(event); },
+        [&](const uint64_t client, const NamedPipeInputDataVersion::v2* data) { OnData(client, *data); }));
+    // v3
+    named_pipes_.emplace_back(std::make_unique<IpcMessageListener>(
+        std::regex_replace(base_name, std::regex("\\$version"), "v3"),
+        named_pipe_v3_max_message_length,
+        [&](const IpcListenerEvent& event) { OnEvent(event); },
+        [&](const uint64_t client, const std::span<const char> message) { return OnV3Message(client, message); }));
 
     for (const auto& pipe : named_pipes_) {
       pipe->StartListening();
@@ -114,76 +160,216 @@ class NamedPipeCommunicationManager::Impl {
     is_listening_ = true;
   }
 
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+    connection_state_callback_ = std::move(callback);
+  }
+
   [[nodiscard]] bool IsListening() const {
     return is_listening_;
   }
 
+  void GetStatistics(og::DeviceLinkStatistics& out_statistics) const {
+    link_statistics_.GetStatistics(out_statistics);
+
+    out_statistics.dropped_packets = rejected_samples_.load(std::memory_order_relaxed);
+  }
+
  private:
-  void OnEvent(const NamedPipeListenerEvent& event) {
+  // v1 and v2 samples don't say when they were taken, so are arbitrated by when they arrived
+  template <typename T>
+  void OnData(const uint64_t client, const T& sample) {
+    const auto arrived = std::chrono::steady_clock::now();
+    link_statistics_.CountBytesRead(sizeof sample);
+
+    if (!Arbitrate(client, arrived, arrived)) {
+      rejected_samples_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    link_statistics_.CountSample(arrived);
+
+    on_data_callback_(ToInput(sample));
+  }
+
+  bool OnV3Message(const uint64_t client, const std::span<const char> message) {
+    using NamedPipeInputDataVersion::v3_header;
+    using NamedPipeInputDataVersion::v3_sample;
+
+    const auto arrived = std::chrono::steady_clock::now();
+
+    // the event loop hands the message over aligned for any type, so the header and samples are read where they are
+    const auto* header = reinterpret_cast<const v3_header*>(message.data());
+    if (message.size() < sizeof(v3_header) || header->version != named_pipe_v3_version || header->sample_count == 0 ||
+        header->sample_count > named_pipe_v3_max_samples || message.size() != sizeof(v3_header) + header->sample_count * sizeof(v3_sample)) {
+      // a client that reconnects and sends the same again would otherwise flood the log
+      OG_LOG_EVERY_MS(
+          og::log_rate_limit_ms,
+          og::kLoggerLevel_Error,
+          "Named pipe client %llu sent a malformed v3 message",
+          static_cast<unsigned long long>(client));
+      link_statistics_.CountDecodeError();
+      return false;
+    }
+
+    link_statistics_.CountBytesRead(message.size());
+
+    const auto session = sessions_.find(client);
+    if (session != sessions_.end()) {
+      // a sequence that goes backwards is a producer that started again, which is not a gap
+      if (session->second.has_sequence && header->sequence > session->second.next_sequence) {
+        link_statistics_.CountLostSamples(header->sequence - session->second.next_sequence);
+      }
+
+      session->second.has_sequence = true;
+      session->second.next_sequence = header->sequence + header->sample_count;
+    }
+
+    // the producer's steady clock is the same as ours, as it is the system's monotonic clock
+    const auto sent = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(header->timestamp_ns));
+    link_statistics_.CountLatency(arrived - sent);
+
+    // a batch is forwarded or rejected whole, as only its last sample says when it was taken
+    if (!Arbitrate(client, sent, arrived)) {
+      rejected_samples_.fetch_add(header->sample_count, std::memory_order_relaxed);
+      return true;
+    }
+
+    const auto* samples = reinterpret_cast<const v3_sample*>(message.data() + sizeof(v3_header));
+    for (uint32_t i = 0; i < header->sample_count; i++) {
+      link_statistics_.CountSample(arrived);
+
+      on_data_callback_(ToInput(samples[i]));
+    }
+
+    return true;
+  }
+
+  // whether the sample the client sent should be forwarded
+  bool Arbitrate(const uint64_t client, const std::chrono::steady_clock::time_point sent, const std::chrono::steady_clock::time_point arrived) {
+    const auto session = sessions_.find(client);
+    if (session == sessions_.end()) return false;
+
+    session->second.has_sent = true;
+    session->second.last_sample = arrived;
+
+    switch (arbitration_) {
+      case og::kNamedPipeArbitration_LastWriter:
+        return true;
+
+      case og::kNamedPipeArbitration_Priority:
+        // clients are numbered in the order they connected, so the first one still sending is the one that connected first
+        for (const auto& [id, other] : sessions_) {
+          if (other.has_sent && arrived - other.last_sample < named_pipe_priority_timeout) return id == client;
+        }
+        return true;
+
+      case og::kNamedPipeArbitration_Freshest:
+        if (sent <= last_forwarded_sent_) return false;
+
+        last_forwarded_sent_ = sent;
+        return true;
+    }
+
+    return true;
+  }
+
+  void OnEvent(const IpcListenerEvent& event) {
     switch (event.type) {
-      case NamedPipeListenerEventType::ClientConnected:
-        if (client_registered_ || !on_client_connected_callback_) return;
-        on_client_connected_callback_();
+      case IpcListenerEventType::ClientConnected: {
+        link_statistics_.CountClientConnected();
+
+        const bool first = sessions_.empty();
+        sessions_[event.client] = {};
+
+        logger.Log(
+            og::kLoggerLevel_Info,
+            "Named pipe client %llu connected for %s hand (%zu connected)",
+            static_cast<unsigned long long>(event.client),
+            hand_ == og::kHandLeft ? "left" : "right",
+            sessions_.size());
+
+        if (!first) return;
+
+        // the hand only counts as reconnected once every client before had gone away
+        if (client_registered_) {
+          link_statistics_.CountReconnect();
+          SetConnectionState(og::kDeviceConnectionState_Connected);
+          return;
+        }
+
         client_registered_ = true;
+        if (on_client_connected_callback_) on_client_connected_callback_();
+        break;
+      }
+
+      case IpcListenerEventType::ClientDisconnected:
+        link_statistics_.CountClientDisconnected();
+
+        sessions_.erase(event.client);
+
+        logger.Log(
+            og::kLoggerLevel_Info,
+            "Named pipe client %llu disconnected from %s hand (%zu connected)",
+            static_cast<unsigned long long>(event.client),
+            hand_ == og::kHandLeft ? "left" : "right",
+            sessions_.size());
+
+        if (sessions_.empty()) SetConnectionState(og::kDeviceConnectionState_Disconnected);
+        break;
+
+      default:
         break;
     }
   }
 
+  void SetConnectionState(const og::DeviceConnectionState state) {
+    if (connection_state_callback_) connection_state_callback_(state);
+  }
+
   bool is_listening_ = false;
   bool client_registered_ = false;
   og::Hand hand_;
-  std::vector<std::unique_ptr<INamedPipeListener>> named_pipes_;
+  og::NamedPipeArbitration arbitration_;
+  std::vector<std::unique_ptr<IIpcListener>> named_pipes_;
   std::function<void()> on_client_connected_callback_;
-  std::function<void(const NamedPipeInputData&)> on_data_callback_;
+  std::function<void(const og::Input&)> on_data_callback_;
+  std::function<void(og::DeviceConnectionState)> connection_state_callback_;
+
+  // only touched from the ipc event loop's thread, which calls back for every pipe one at a time
+  std::map<uint64_t, NamedPipeClientSession> sessions_;
+  std::chrono::steady_clock::time_point last_forwarded_sent_{};
+
+  LinkStatistics link_statistics_;
+  std::atomic<uint64_t> rejected_samples_ = 0;  // samples that arbitration kept from being forwarded
 };
 
-NamedPipeCommunicationManager::NamedPipeCommunicationManager(og::Hand hand, std::function<void()> on_client_connected)
-    : on_client_connected_(std::move(on_client_connected)), pImpl_(std::make_unique<Impl>(hand, [&]() { on_client_connected_(); })){};
+NamedPipeCommunicationManager::NamedPipeCommunicationManager(
+    og::Hand hand, const og::NamedPipeCommunicationConfiguration& configuration, std::function<void()> on_client_connected)
+    : on_client_connected_(std::move(on_client_connected)), pImpl_(std::make_unique<Impl>(hand, configuration, [&]() { on_client_connected_(); })){};
 
 void NamedPipeCommunicationManager::BeginListener(std::function<void(const og::Input&)> callback) {
   on_data_callback_ = std::move(callback);
 
   if (pImpl_->IsListening()) return;
 
-  pImpl_->StartListener([&](const NamedPipeInputData& pipe_data) {
-    logger.Log(og::kLoggerLevel_Info, "Received named pipe data");
-
-    og::Input result{};
-    result.type = og::kInputDataType_Peripheral;
-
-    og::InputPeripheralData& data = result.data.peripheral;
-
-    data.flexion = pipe_data.flexion;
-    data.splay = pipe_data.splay;
-
-    data.A.pressed = pipe_data.a_button;
-    data.A.value = pipe_data.a_button;
-
-    data.B.pressed = pipe_data.b_button;
-    data.B.value = pipe_data.b_button;
-
-    data.trigger.pressed = pipe_data.trigger_button;
-    data.trigger.value = pipe_data.trigger_value;
-
-    data.joystick.x = pipe_data.joy_x;
-    data.joystick.y = pipe_data.joy_y;
-    data.joystick.pressed = pipe_data.joy_button;
-
-    data.calibrate.pressed = pipe_data.calibrate;
-    data.calibrate.value = pipe_data.calibrate;
-
-    data.grab.activated = pipe_data.grab;
-    data.pinch.activated = pipe_data.pinch;
-
-    data.menu.pressed = pipe_data.menu;
-    data.menu.value = pipe_data.menu;
+  pImpl_->StartListener([&](const og::Input& input) { on_data_callback_(input); });
+}
 
-    on_data_callback_(result);
-  });
+void NamedPipeCommunicationManager::ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+  // disconnected once every client has gone away, and connected again when the next one connects
+  pImpl_->ListenForConnectionState(std::move(callback));
 }
 
 void NamedPipeCommunicationManager::WriteOutput(const og::Output& output) {
   // not implemented yet
 }
 
+og::DeviceStatistics NamedPipeCommunicationManager::GetStatistics() {
+  // named pipe data is not encoded, so only the link is counted
+  og::DeviceStatistics result{};
+  pImpl_->GetStatistics(result.link);
+
+  return result;
+}
+
 NamedPipeCommunicationManager::~NamedPipeCommunicationManager() = default;
\ No newline at end of file
@@ -14,12 +14,16 @@
 
 class NamedPipeCommunicationManager : public ICommunicationManager {
  public:
-  NamedPipeCommunicationManager(og::Hand hand, std::function<void()> on_client_connected);
+  NamedPipeCommunicationManager(
+      og::Hand hand, const og::NamedPipeCommunicationConfiguration& configuration, std::function<void()> on_client_connected);
 
   void BeginListener(std::function<void(const og::Input&)> callback) override;
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) override;
 
   void WriteOutput(const og::Output& output) override;
 
+  og::DeviceStatistics GetStatistics() override;
+
   ~NamedPipeCommunicationManager() override;
 
  private:
@@ -0,0 +1,155 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "output_scheduler.h"
+
+#include <algorithm>
+
+using namespace og;
+
+static Logger& logger = Logger::GetInstance();
+
+struct OutputSchedule {
+  int priority;  // lower is written first
+  // how long an output is worth writing for after being queued, zero if it never goes stale (ie. force feedback is a position to hold, so the
+  // latest is always worth sending)
+  std::chrono::milliseconds deadline;
+};
+
+static constexpr OutputSchedule GetOutputSchedule(const OutputDataType type) {
+  switch (type) {
+    case kOutputData_Type_ForceFeedback:
+      return {0, std::chrono::milliseconds(0)};
+    case kOutputDataType_FetchInfo:
+    case kOutputDataType_Configure:
+      return {1, std::chrono::milliseconds(0)};
+    // another is asked for if the device is still desynchronised
+    case kOutputDataType_RequestKeyframe:
+      return {1, std::chrono::milliseconds(100)};
+    // a vibration that starts this late is felt out of step with what caused it
+    case kOutputDataType_Haptic:
+      return {2, std::chrono::milliseconds(50)};
+    default:
+      return {3, std::chrono::milliseconds(0)};
+  }
+}
+
+// output types in the order they are packed into a write
+static constexpr std::array<OutputDataType, kOutputDataType_Max> output_pack_order = [] {
+  std::array<OutputDataType, kOutputDataType_Max> result{};
+  for (int i = 0; i < kOutputDataType_Max; i++) result[i] = static_cast<OutputDataType>(i);
+
+  std::sort(result.begin(), result.end(), [](const OutputDataType a, const OutputDataType b) {
+    const int a_priority = GetOutputSchedule(a).priority, b_priority = GetOutputSchedule(b).priority;
+    return a_priority != b_priority ? a_priority < b_priority : a < b;
+  });
+
+  return result;
+}();
+
+void OutputScheduler::CountQueued(const OutputDataType type) {
+  counters_[type].queued.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t OutputScheduler::CountDropped(const OutputDataType type) {
+  counters_[type].queued.fetch_sub(1, std::memory_order_relaxed);
+  return counters_[type].dropped.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void OutputScheduler::Push(const Output& output, const std::chrono::steady_clock::time_point queued) {
+  PendingOutput& pending = outputs_[output.type];
+
+  if (pending.pending) {
+    counters_[output.type].queued.fetch_sub(1, std::memory_order_relaxed);
+    counters_[output.type].superseded.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  pending = {.output = output, .queued = queued, .pending = true, .packed = false};
+}
+
+bool OutputScheduler::HasPending() const {
+  return std::any_of(outputs_.begin(), outputs_.end(), [](const PendingOutput& output) { return output.pending && !output.packed; });
+}
+
+void OutputScheduler::Pack(
+    IEncodingService& encoding_service, const std::chrono::steady_clock::time_point now, std::span<char> buff, size_t& out_length) {
+  out_length = 0;
+
+  for (const OutputDataType type : output_pack_order) {
+    PendingOutput& pending = outputs_[type];
+    if (!pending.pending || pending.packed) continue;
+
+    const std::chrono::milliseconds deadline = GetOutputSchedule(type).deadline;
+    if (deadline.count() > 0 && now - pending.queued > deadline) {
+      pending.pending = false;
+      counters_[type].queued.fetch_sub(1, std::memory_order_relaxed);
+      counters_[type].expired.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    size_t encoded_length;
+    if (!encoding_service.EncodePacket(pending.output, buff.subspan(out_length), encoded_length)) {
+      // it would not fit in a write on its own, so waiting for the next write won't help
+      if (out_length == 0) {
+        OG_LOG_EVERY_MS_WITH(
+            dropped_output_log_limiter_,
+            log_rate_limit_ms,
+            kLoggerLevel_Warning,
+            "Dropped output to device as it could not be encoded into a single write.");
+        pending.pending = false;
+        CountDropped(type);
+      }
+
+      // otherwise it waits for the next write, a smaller lower priority output may still fit into this one
+      continue;
+    }
+
+    out_length += encoded_length;
+    pending.packed = true;
+  }
+}
+
+void OutputScheduler::MarkWritten(const std::chrono::steady_clock::time_point written) {
+  for (size_t type = 0; type < outputs_.size(); type++) {
+    PendingOutput& pending = outputs_[type];
+    if (!pending.packed) continue;
+
+    pending.pending = false;
+    pending.packed = false;
+
+    counters_[type].queued.fetch_sub(1, std::memory_order_relaxed);
+    counters_[type].written.fetch_add(1, std::memory_order_relaxed);
+
+    const auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(written - pending.queued).count());
+    last_latency_ns_.store(latency, std::memory_order_relaxed);
+    total_latency_ns_.fetch_add(latency, std::memory_order_relaxed);
+
+    // only the writer thread stores a new maximum, so this can't race with another store
+    if (latency > max_latency_ns_.load(std::memory_order_relaxed)) max_latency_ns_.store(latency, std::memory_order_relaxed);
+  }
+}
+
+void OutputScheduler::MarkFailed() {
+  for (PendingOutput& pending : outputs_) pending.packed = false;
+}
+
+void OutputScheduler::GetStatistics(DeviceWriteStatistics& out_statistics) const {
+  for (size_t type = 0; type < counters_.size(); type++) {
+    const OutputCounters& counters = counters_[type];
+
+    out_statistics.outputs[type] = {
+        .queued = counters.queued.load(std::memory_order_relaxed),
+        .written = counters.written.load(std::memory_order_relaxed),
+        .superseded = counters.superseded.load(std::memory_order_relaxed),
+        .expired = counters.expired.load(std::memory_order_relaxed),
+        .dropped = counters.dropped.load(std::memory_order_relaxed),
+    };
+  }
+
+  out_statistics.last_latency_ns = last_latency_ns_.load(std::memory_order_relaxed);
+  out_statistics.max_latency_ns = max_latency_ns_.load(std::memory_order_relaxed);
+  out_statistics.total_latency_ns = total_latency_ns_.load(std::memory_order_relaxed);
+}
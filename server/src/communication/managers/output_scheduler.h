@@ -0,0 +1,73 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+#include "communication/encoding/encoding_service.h"
+#include "opengloves_interface.h"
+
+/**
+ * Decides which outputs go into each write to a device. Only the latest output of each type is kept, as a newer one always supersedes it (ie. a
+ * force feedback update replaces the last, rather than queueing behind it). Each write takes the outputs in order of their type's priority,
+ * skipping those that have waited past their type's deadline, until the transport's write budget is used.
+ *
+ * Push, Pack, MarkWritten and MarkFailed are only to be called from the writer thread. The Count functions and GetStatistics are safe from any
+ * thread.
+ */
+class OutputScheduler {
+ public:
+  // an output has been queued for the writer thread, so it is counted as waiting until it is written or dropped
+  void CountQueued(og::OutputDataType type);
+  // an output was dropped before it reached the scheduler (ie. the queue to the writer thread was full). Returns how many of the type have been
+  // dropped, including this one
+  uint64_t CountDropped(og::OutputDataType type);
+
+  void Push(const og::Output& output, std::chrono::steady_clock::time_point queued);
+
+  // whether there are outputs waiting that were not packed into the last write
+  bool HasPending() const;
+
+  // encodes the waiting outputs that fit into buff, in priority order. The packed outputs are held until MarkWritten
+  void Pack(IEncodingService& encoding_service, std::chrono::steady_clock::time_point now, std::span<char> buff, size_t& out_length);
+
+  // the write with the outputs from the last Pack has returned
+  void MarkWritten(std::chrono::steady_clock::time_point written);
+  // the write with the outputs from the last Pack failed, they are packed again by the next Pack unless they expire or are superseded first
+  void MarkFailed();
+
+  void GetStatistics(og::DeviceWriteStatistics& out_statistics) const;
+
+ private:
+  struct PendingOutput {
+    og::Output output;
+    std::chrono::steady_clock::time_point queued;
+    bool pending;
+    bool packed;
+  };
+  std::array<PendingOutput, og::kOutputDataType_Max> outputs_{};
+
+  struct OutputCounters {
+    std::atomic<uint64_t> queued;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> superseded;
+    std::atomic<uint64_t> expired;
+    std::atomic<uint64_t> dropped;
+  };
+  std::array<OutputCounters, og::kOutputDataType_Max> counters_{};
+
+  // this device's, so that another's dropped outputs don't hide its own
+  og::LogRateLimiter dropped_output_log_limiter_;
+
+  std::atomic<uint64_t> last_latency_ns_ = 0;
+  std::atomic<uint64_t> max_latency_ns_ = 0;
+  std::atomic<uint64_t> total_latency_ns_ = 0;
+};
@@ -0,0 +1,152 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "shared_memory_communication_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include "link_statistics.h"
+#include "opengloves_interface.h"
+#include "shared_memory/shared_memory_input.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+// how long the listener waits for a frame before checking whether it should stop
+static constexpr auto shared_memory_wait_timeout = std::chrono::milliseconds(250);
+
+// a source that hasn't published for this long has stopped (or been closed)
+static constexpr auto shared_memory_producer_timeout = std::chrono::seconds(1);
+
+class SharedMemoryCommunicationManager::Impl {
+ public:
+  explicit Impl(const og::Hand hand) : name_(GetSharedMemoryInputName(hand)) {
+    segment_ = SharedMemoryInput::Create(name_);
+
+    if (segment_ == nullptr) {
+      logger.Log(og::kLoggerLevel_Error, "Failed to create shared memory input segment %s", name_.c_str());
+      return;
+    }
+
+    logger.Log(og::kLoggerLevel_Info, "Created shared memory input segment %s", name_.c_str());
+  }
+
+  void BeginListener(std::function<void(const og::Input&)> callback) {
+    if (segment_ == nullptr || thread_active_.exchange(true)) return;
+
+    callback_ = std::move(callback);
+    listener_thread_ = std::thread(&SharedMemoryCommunicationManager::Impl::ListenerThread, this);
+  }
+
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+    connection_state_callback_ = std::move(callback);
+  }
+
+  og::DeviceStatistics GetStatistics() const {
+    // the frame is not encoded, so only the link is counted
+    og::DeviceStatistics result{};
+    link_statistics_.GetStatistics(result.link);
+
+    result.link.dropped_packets = overwritten_frames_.load(std::memory_order_relaxed);
+
+    return result;
+  }
+
+  ~Impl() {
+    if (thread_active_.exchange(false)) listener_thread_.join();
+  }
+
+ private:
+  void ListenerThread() {
+    // whatever is in the segment already was published before we were listening
+    uint32_t read_sequence = segment_->GetSequence();
+
+    bool producer_active = false;
+    bool producer_seen = false;
+    uint64_t last_frame = 0;
+    auto last_published = std::chrono::steady_clock::now();
+
+    while (thread_active_) {
+      if (!segment_->WaitForPublish(read_sequence, shared_memory_wait_timeout)) {
+        if (producer_active && std::chrono::steady_clock::now() - last_published > shared_memory_producer_timeout) {
+          logger.Log(og::kLoggerLevel_Warning, "Shared memory input source for %s stopped publishing", name_.c_str());
+
+          producer_active = false;
+          SetConnectionState(og::kDeviceConnectionState_Disconnected);
+        }
+
+        continue;
+      }
+
+      // if this fails, the producer died mid write and the wait above is for it (or another) to carry on from the sequence it left
+      SharedMemoryInputFrame frame;
+      if (!segment_->Read(frame, read_sequence)) continue;
+
+      last_published = std::chrono::steady_clock::now();
+
+      if (!producer_active) {
+        logger.Log(og::kLoggerLevel_Info, "Shared memory input source for %s started publishing", name_.c_str());
+
+        if (producer_seen) link_statistics_.CountReconnect();
+        producer_active = true;
+        producer_seen = true;
+        SetConnectionState(og::kDeviceConnectionState_Connected);
+      } else if (frame.frame > last_frame + 1) {
+        overwritten_frames_.fetch_add(frame.frame - last_frame - 1, std::memory_order_relaxed);
+      }
+      last_frame = frame.frame;
+
+      link_statistics_.CountBytesRead(sizeof frame);
+      link_statistics_.CountSample(last_published);
+
+      og::Input input{};
+      input.type = og::kInputDataType_Peripheral;
+      input.data.peripheral = frame.data;
+
+      callback_(input);
+    }
+  }
+
+  void SetConnectionState(const og::DeviceConnectionState state) {
+    if (connection_state_callback_) connection_state_callback_(state);
+  }
+
+  std::string name_;
+  std::unique_ptr<SharedMemoryInput> segment_;
+
+  std::atomic<bool> thread_active_ = false;
+  std::thread listener_thread_;
+
+  std::function<void(const og::Input&)> callback_;
+  std::function<void(og::DeviceConnectionState)> connection_state_callback_;
+
+  LinkStatistics link_statistics_;
+
+  // frames published faster than they were read, which only the newest of was taken
+  std::atomic<uint64_t> overwritten_frames_ = 0;
+};
+
+SharedMemoryCommunicationManager::SharedMemoryCommunicationManager(const og::Hand hand) : pImpl_(std::make_unique<Impl>(hand)) {}
+
+void SharedMemoryCommunicationManager::BeginListener(std::function<void(const og::Input&)> callback) {
+  pImpl_->BeginListener(std::move(callback));
+}
+
+void SharedMemoryCommunicationManager::ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+  pImpl_->ListenForConnectionState(std::move(callback));
+}
+
+void SharedMemoryCommunicationManager::WriteOutput(const og::Output& output) {
+  // software sources take force feedback from its own named pipe, as with the named pipe input
+}
+
+og::DeviceStatistics SharedMemoryCommunicationManager::GetStatistics() {
+  return pImpl_->GetStatistics();
+}
+
+SharedMemoryCommunicationManager::~SharedMemoryCommunicationManager() = default;
@@ -0,0 +1,32 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <memory>
+
+#include "communication_manager.h"
+#include "opengloves_interface.h"
+
+// input from a software source (ie. a hand tracking app) that publishes its newest frame to a shared memory segment for the hand (see
+// shared_memory/shared_memory_input.h)
+class SharedMemoryCommunicationManager : public ICommunicationManager {
+ public:
+  explicit SharedMemoryCommunicationManager(og::Hand hand);
+
+  void BeginListener(std::function<void(const og::Input&)> callback) override;
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) override;
+
+  void WriteOutput(const og::Output& output) override;
+
+  og::DeviceStatistics GetStatistics() override;
+
+  ~SharedMemoryCommunicationManager() override;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
@@ -0,0 +1,39 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "hotplug_watcher.h"
+
+// the platform's Impl is in hotplug_watcher_<platform>.cpp, and calls OnChange from its own thread
+uint64_t HotplugWatcher::GetChanges() {
+  std::scoped_lock lock(mutex_);
+
+  return changes_;
+}
+
+uint64_t HotplugWatcher::WaitForChange(const uint64_t seen_changes, const std::chrono::milliseconds timeout) {
+  std::unique_lock lock(mutex_);
+  changed_.wait_for(lock, timeout, [&]() { return stopped_ || changes_ > seen_changes; });
+
+  return changes_;
+}
+
+void HotplugWatcher::Stop() {
+  {
+    std::scoped_lock lock(mutex_);
+    stopped_ = true;
+  }
+
+  changed_.notify_all();
+}
+
+void HotplugWatcher::OnChange() {
+  {
+    std::scoped_lock lock(mutex_);
+    changes_++;
+  }
+
+  changed_.notify_all();
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Watches for serial devices being plugged in or taken out, so that the probers looking for them can wait for something to change rather than
+ * looking every few seconds. On linux this is inotify on /dev, /dev/serial and /dev/serial/by-id, and on the configured ports themselves wherever
+ * they are (so a symlink to a pty made for testing is seen too). Nothing is watched on other platforms, where IsWatching is false and probers
+ * should carry on polling.
+ */
+class HotplugWatcher {
+ public:
+  // device_paths are the configured ports, any of which may be outside of /dev
+  explicit HotplugWatcher(const std::vector<std::string>& device_paths);
+
+  // whether changes are being watched for at all, if not, WaitForChange only ever returns at the timeout
+  [[nodiscard]] bool IsWatching() const;
+
+  // changes seen so far, to wait for the next from
+  uint64_t GetChanges();
+
+  // waits until there have been more than seen_changes, timeout has passed or the watcher is stopped. Returns the changes seen so far
+  uint64_t WaitForChange(uint64_t seen_changes, std::chrono::milliseconds timeout);
+
+  // wakes every waiter, and returns from every wait straight away after
+  void Stop();
+
+  ~HotplugWatcher();
+
+ private:
+  void OnChange();
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  uint64_t changes_ = 0;
+  bool stopped_ = false;
+
+  // last, so that its thread has stopped before the above goes
+  class Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
@@ -0,0 +1,186 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hotplug_watcher.h"
+#include "opengloves_interface.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+// where udev puts serial devices and the symlinks to them. The last two only exist while a usb serial device is plugged in
+static const std::vector<std::filesystem::path> hotplug_device_directories = {"/dev", "/dev/serial", "/dev/serial/by-id"};
+
+static constexpr uint32_t hotplug_watch_events = IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO;
+
+// a device being plugged in comes as a burst of events (its node, then its permissions, then the symlinks to it), which are taken together as one
+// change as long as they keep coming this close together, for up to hotplug_settle_max_time
+static constexpr int hotplug_settle_time_ms = 50;
+static constexpr auto hotplug_settle_max_time = std::chrono::milliseconds(250);
+
+class HotplugWatcher::Impl {
+ public:
+  Impl(const std::vector<std::string>& device_paths, std::function<void()> on_change) : on_change_(std::move(on_change)) {
+    // everything in the device directories is of interest
+    for (const auto& directory : hotplug_device_directories) directories_[directory];
+
+    // but only the ports themselves anywhere else, as they may be in a busy directory (ie. a symlink in /tmp)
+    for (const auto& device_path : device_paths) {
+      const std::filesystem::path path(device_path);
+      if (!path.is_absolute() || !path.has_filename()) continue;
+
+      const auto directory = directories_.find(path.parent_path());
+      if (directory != directories_.end() && directory->second.empty()) continue;
+
+      directories_[path.parent_path()].insert(path.filename().string());
+    }
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (inotify_fd_ < 0 || wake_fd_ < 0) {
+      logger.Log(og::kLoggerLevel_Error, "Failed to watch for serial devices being plugged in: %s", std::strerror(errno));
+      return;
+    }
+
+    AddWatches();
+    if (watches_.empty()) {
+      logger.Log(og::kLoggerLevel_Error, "Failed to watch any device directory for serial devices being plugged in");
+      return;
+    }
+
+    is_watching_ = true;
+    thread_ = std::thread(&HotplugWatcher::Impl::WatchThread, this);
+  }
+
+  [[nodiscard]] bool IsWatching() const {
+    return is_watching_;
+  }
+
+  ~Impl() {
+    if (thread_.joinable()) {
+      const uint64_t wake = 1;
+      if (write(wake_fd_, &wake, sizeof wake) != sizeof wake) logger.Log(og::kLoggerLevel_Error, "Failed to stop hotplug watcher");
+
+      thread_.join();
+    }
+
+    if (inotify_fd_ >= 0) close(inotify_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+  }
+
+ private:
+  void WatchThread() {
+    std::array<pollfd, 2> fds = {{{.fd = inotify_fd_, .events = POLLIN, .revents = 0}, {.fd = wake_fd_, .events = POLLIN, .revents = 0}}};
+
+    for (;;) {
+      if (poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) continue;
+
+        logger.Log(og::kLoggerLevel_Error, "Failed waiting for serial devices to be plugged in: %s", std::strerror(errno));
+        return;
+      }
+      if (fds[1].revents != 0) return;
+
+      bool changed = ReadEvents();
+
+      const auto settle_deadline = std::chrono::steady_clock::now() + hotplug_settle_max_time;
+      while (std::chrono::steady_clock::now() < settle_deadline && poll(fds.data(), fds.size(), hotplug_settle_time_ms) > 0) {
+        if (fds[1].revents != 0) return;
+
+        changed |= ReadEvents();
+      }
+
+      // a directory that wasn't there before (ie. /dev/serial/by-id for the first usb serial device) may be now
+      AddWatches();
+
+      if (changed) on_change_();
+    }
+  }
+
+  // returns whether any of the events were for something of interest
+  bool ReadEvents() {
+    bool changed = false;
+
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    for (;;) {
+      const ssize_t length = read(inotify_fd_, buffer.data(), buffer.size());
+      if (length <= 0) return changed;
+
+      for (ssize_t offset = 0; offset < length;) {
+        const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+        // a full queue lost events, which may have been anything
+        if (event->mask & IN_Q_OVERFLOW) {
+          changed = true;
+          continue;
+        }
+
+        const auto watch = watches_.find(event->wd);
+        if (watch == watches_.end()) continue;
+
+        // the directory went away, so is watched again if it comes back
+        if (event->mask & IN_IGNORED) {
+          watches_.erase(watch);
+          continue;
+        }
+
+        // about the directory itself rather than anything in it
+        if (event->len == 0) continue;
+
+        const std::set<std::string>& names = directories_[watch->second];
+        if (names.empty() || names.contains(event->name)) changed = true;
+      }
+    }
+  }
+
+  void AddWatches() {
+    for (const auto& [directory, names] : directories_) {
+      if (std::any_of(watches_.begin(), watches_.end(), [&](const auto& watch) { return watch.second == directory; })) continue;
+
+      const int watch = inotify_add_watch(inotify_fd_, directory.c_str(), hotplug_watch_events);
+      if (watch >= 0) watches_[watch] = directory;
+    }
+  }
+
+  std::function<void()> on_change_;
+
+  // the names of interest in each directory, all of them if empty
+  std::map<std::filesystem::path, std::set<std::string>> directories_;
+  std::map<int, std::filesystem::path> watches_;
+
+  int inotify_fd_ = -1;
+  int wake_fd_ = -1;
+
+  bool is_watching_ = false;
+  std::thread thread_;
+};
+
+HotplugWatcher::HotplugWatcher(const std::vector<std::string>& device_paths)
+    : pImpl_(std::make_unique<Impl>(device_paths, [&]() { OnChange(); })) {}
+
+bool HotplugWatcher::IsWatching() const {
+  return pImpl_->IsWatching();
+}
+
+HotplugWatcher::~HotplugWatcher() = default;
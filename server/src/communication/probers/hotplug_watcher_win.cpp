@@ -0,0 +1,18 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "hotplug_watcher.h"
+
+// com ports are not watched for yet, so probers poll for them
+class HotplugWatcher::Impl {};
+
+HotplugWatcher::HotplugWatcher(const std::vector<std::string>&) {}
+
+bool HotplugWatcher::IsWatching() const {
+  return false;
+}
+
+HotplugWatcher::~HotplugWatcher() = default;
@@ -21,4 +21,6 @@ class ICommunicationProber {
   // The prober should check the device it is about to give back to ensure that it is not already being used.
   // Returns: true if the prober found one or more devices, false if error or no devices found.
   virtual bool InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) = 0;
+
+  virtual ~ICommunicationProber() = default;
 };
\ No newline at end of file
@@ -6,20 +6,109 @@
 
 #include "prober_serial_connectable.h"
 
+#include <array>
+#include <chrono>
+
+#include "communication/encoding/alpha_encoding_service.h"
+#include "communication/encoding/binary_encoding_service.h"
 #include "communication/services/service_serial.h"
 #include "opengloves_interface.h"
 
+static og::Logger& logger = og::Logger::GetInstance();
+
+// tried fastest first, usb serial adapters (ie. cp2102 and ch340) run at the higher rates, older firmware at 115200
+static constexpr std::array<unsigned int, 8> auto_baud_rates = {2000000, 1500000, 1000000, 921600, 500000, 460800, 230400, 115200};
+
+// long enough for a device that only streams once asked to answer the request for its info
+static constexpr auto auto_baud_listen_time = std::chrono::milliseconds(400);
+
+// at the wrong rate a device's bytes come out as noise, which may now and then happen to decode
+static constexpr int auto_baud_valid_packets = 3;
+
+// opened at when nothing could be detected, as the port always was before rates could be configured. A board that resets when the port is
+// opened (ie. an arduino nano or esp32 devkit) may still be booting for the whole of every rate's listen time
+static constexpr unsigned int auto_baud_fallback_rate = 115200;
+
+// whether what the device sends decodes, either as alpha packets or binary frames
+static bool IsDeviceReadable(ICommunicationService& service) {
+  AlphaEncodingService alpha_encoding_service({.max_analog_value = 4095});
+  BinaryEncodingService binary_encoding_service;
+  const std::array<IEncodingService*, 2> encoding_services = {&alpha_encoding_service, &binary_encoding_service};
+
+  // the device may be waiting to be asked for something before it sends anything
+  const og::Output fetch_info = {.type = og::kOutputDataType_FetchInfo, .data = {.fetch_info = {.start_streaming = false, .get_info = true}}};
+  for (IEncodingService* encoding_service : encoding_services) {
+    std::array<char, 64> request{};
+    size_t request_length;
+    if (encoding_service->EncodePacket(fetch_info, request, request_length)) service.RawWrite(std::string_view(request.data(), request_length));
+  }
+
+  std::array<char, 1024> buffer{};
+  std::array<og::Input, 16> inputs{};
+  std::array<og::DecodeStatus, 16> statuses{};
+
+  int valid_packets = 0;
+  const auto deadline = std::chrono::steady_clock::now() + auto_baud_listen_time;
+  while (std::chrono::steady_clock::now() < deadline) {
+    size_t bytes_read;
+    if (!service.ReceiveNextChunk(buffer, bytes_read)) return false;
+
+    for (IEncodingService* encoding_service : encoding_services) {
+      for (std::string_view chunk(buffer.data(), bytes_read); !chunk.empty();) {
+        const DecodeChunkResult result = encoding_service->DecodeChunk(chunk, inputs, statuses);
+        chunk.remove_prefix(result.consumed);
+
+        for (size_t i = 0; i < result.emitted; i++) {
+          if (statuses[i] == og::kDecodeStatus_Ok) valid_packets++;
+        }
+      }
+    }
+
+    if (valid_packets >= auto_baud_valid_packets) return true;
+  }
+
+  return false;
+}
+
 SerialPortProber::SerialPortProber(const SerialPortProberConfiguration& configuration) {
   port_ = configuration.port;
+  baud_rate_ = configuration.baud_rate;
 }
 
 bool SerialPortProber::InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) {
-  og::DeviceSerialCommunicationConfiguration config{port_};
-  auto device = std::make_unique<SerialCommunicationService>(config);
-  if (device->IsConnected()) {
-    out_devices.push_back(std::move(device));
-    return true;
+  if (baud_rate_ != 0) {
+    auto device = std::make_unique<SerialCommunicationService>(og::DeviceSerialCommunicationConfiguration{port_, baud_rate_});
+    if (device->IsConnected()) {
+      out_devices.push_back(std::move(device));
+      return true;
+    }
+
+    return false;
   }
 
-  return false;
-}
\ No newline at end of file
+  for (const unsigned int baud_rate : auto_baud_rates) {
+    auto device = std::make_unique<SerialCommunicationService>(og::DeviceSerialCommunicationConfiguration{port_, baud_rate});
+
+    // nothing is there (or it is in use), so no other rate will do any better
+    if (!device->IsConnected()) return false;
+
+    if (IsDeviceReadable(*device)) {
+      logger.Log(og::kLoggerLevel_Info, "Detected baud rate of %u on %s", baud_rate, port_.c_str());
+
+      out_devices.push_back(std::move(device));
+      return true;
+    }
+  }
+
+  logger.Log(
+      og::kLoggerLevel_Warning,
+      "Could not detect the baud rate of %s, nothing it sent could be decoded. Falling back to %u",
+      port_.c_str(),
+      auto_baud_fallback_rate);
+
+  auto device = std::make_unique<SerialCommunicationService>(og::DeviceSerialCommunicationConfiguration{port_, auto_baud_fallback_rate});
+  if (!device->IsConnected()) return false;
+
+  out_devices.push_back(std::move(device));
+  return true;
+}
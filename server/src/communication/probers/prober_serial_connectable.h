@@ -15,6 +15,7 @@
 
 struct SerialPortProberConfiguration {
   std::string port;
+  unsigned int baud_rate;  // 0 to detect the rate the device is sending at, or use 115200 if it can't be
 };
 
 class SerialPortProber : public ICommunicationProber {
@@ -25,4 +26,5 @@ class SerialPortProber : public ICommunicationProber {
 
  private:
   std::string port_;
+  unsigned int baud_rate_;
 };
\ No newline at end of file
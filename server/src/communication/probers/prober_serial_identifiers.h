@@ -0,0 +1,15 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#ifdef _WIN32
+#include "prober_serial_identifiers_win.h"
+#else
+#ifdef __linux__
+#include "prober_serial_linux.h"
+#endif
+#endif
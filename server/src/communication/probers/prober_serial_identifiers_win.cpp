@@ -29,7 +29,7 @@ using namespace og;
 
 static Logger& logger = Logger::GetInstance();
 
-SerialIdentifierProber::SerialIdentifierProber(SerialProberIdentifier identifier) {
+SerialIdentifierProber::SerialIdentifierProber(SerialProberIdentifier identifier, const unsigned int baud_rate) : baud_rate_(baud_rate) {
   // convert serial pid vid struct to a string we can easily search for
   identifier_ = "VID_" + identifier.vid + "&PID_" + identifier.pid;
 }
@@ -78,7 +78,7 @@ bool SerialIdentifierProber::InquireDevices(std::vector<std::unique_ptr<ICommuni
           (type == REG_SZ)) {
         std::string port = std::string(R"(\\.\)") + port_name;
 
-        SerialPortProber port_prober({port});
+        SerialPortProber port_prober({port, baud_rate_});
         port_prober.InquireDevices(out_devices);
 
         found_devices++;
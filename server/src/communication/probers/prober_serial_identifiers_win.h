@@ -20,9 +20,11 @@ struct SerialProberIdentifier {
 
 class SerialIdentifierProber : public ICommunicationProber {
  public:
-  explicit SerialIdentifierProber(SerialProberIdentifier identifier);
+  // baud_rate is the rate the devices found are opened at, 0 to detect it
+  SerialIdentifierProber(SerialProberIdentifier identifier, unsigned int baud_rate);
 
   bool InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) override;
  private:
   std::string identifier_;
+  unsigned int baud_rate_;
 };
\ No newline at end of file
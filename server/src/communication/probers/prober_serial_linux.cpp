@@ -0,0 +1,73 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "prober_serial_linux.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "opengloves_interface.h"
+#include "prober_serial_connectable.h"
+
+using namespace og;
+
+static Logger& logger = Logger::GetInstance();
+
+static const std::filesystem::path sysfs_tty_path = "/sys/class/tty";
+
+// the tty's device is a usb interface (or a port below one), the ids are on the usb device a few levels above it
+static constexpr int max_usb_device_depth = 4;
+
+static std::string ToLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+  return value;
+}
+
+static std::string ReadSysfsValue(const std::filesystem::path& path) {
+  std::ifstream file(path);
+
+  std::string value;
+  std::getline(file, value);
+
+  return ToLower(value);
+}
+
+SerialIdentifierProber::SerialIdentifierProber(SerialProberIdentifier identifier, const unsigned int baud_rate)
+    : identifier_({ToLower(std::move(identifier.vid)), ToLower(std::move(identifier.pid))}), baud_rate_(baud_rate) {}
+
+bool SerialIdentifierProber::InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) {
+  std::error_code error;
+  std::filesystem::directory_iterator ttys(sysfs_tty_path, error);
+  if (error) {
+    logger.Log(og::kLoggerLevel_Error, "Failed to set up serial prober: %s", error.message().c_str());
+
+    return false;
+  }
+
+  int found_devices = 0;
+  for (const auto& tty : ttys) {
+    // virtual terminals have no device behind them
+    std::filesystem::path device = std::filesystem::canonical(tty.path() / "device", error);
+    if (error) continue;
+
+    for (int depth = 0; depth < max_usb_device_depth && !std::filesystem::exists(device / "idVendor"); depth++) device = device.parent_path();
+
+    if (ReadSysfsValue(device / "idVendor") != identifier_.vid || ReadSysfsValue(device / "idProduct") != identifier_.pid) continue;
+
+    SerialPortProber port_prober({"/dev/" + tty.path().filename().string(), baud_rate_});
+    port_prober.InquireDevices(out_devices);
+
+    found_devices++;
+  }
+
+  return found_devices > 0;
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "communication/probers/prober.h"
+#include "communication/services/communication_service.h"
+
+struct SerialProberIdentifier {
+  std::string vid;
+  std::string pid;
+};
+
+// finds the ttys of usb serial adapters with the given vid and pid through sysfs
+class SerialIdentifierProber : public ICommunicationProber {
+ public:
+  // baud_rate is the rate the devices found are opened at, 0 to detect it
+  SerialIdentifierProber(SerialProberIdentifier identifier, unsigned int baud_rate);
+
+  bool InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) override;
+
+ private:
+  SerialProberIdentifier identifier_;
+  unsigned int baud_rate_;
+};
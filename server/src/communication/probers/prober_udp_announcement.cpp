@@ -0,0 +1,111 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "prober_udp_announcement.h"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <utility>
+
+#include "communication/services/service_udp.h"
+
+using namespace og;
+
+static Logger& logger = Logger::GetInstance();
+
+// devices announce themselves about once a second
+static constexpr auto udp_announcement_listen_time = std::chrono::milliseconds(1500);
+
+UdpAnnouncementProber::UdpAnnouncementProber(og::DeviceUdpCommunicationConfiguration configuration) : configuration_(std::move(configuration)) {}
+
+bool UdpAnnouncementProber::OpenDiscoverySocket() {
+  if (!InitialiseSockets()) return false;
+
+  discovery_socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (discovery_socket_ == invalid_socket_handle) return false;
+
+  // the prober for each hand listens on the same port, and each is given every broadcast
+  const int reuse_address = 1;
+  setsockopt(discovery_socket_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse_address), sizeof reuse_address);
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(udp_discovery_port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(discovery_socket_, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0) {
+    logger.Log(kLoggerLevel_Error, "Failed to listen for udp device announcements: %s", GetLastSocketErrorAsString().c_str());
+    CloseSocket(discovery_socket_);
+    discovery_socket_ = invalid_socket_handle;
+
+    return false;
+  }
+
+  return true;
+}
+
+bool UdpAnnouncementProber::InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) {
+  if (found_device_) return false;
+
+  og::DeviceUdpCommunicationConfiguration service_configuration = configuration_;
+
+  if (service_configuration.address.empty()) {
+    if (discovery_socket_ == invalid_socket_handle && !OpenDiscoverySocket()) return false;
+
+    const std::string announcement = std::string(udp_announcement_prefix) + configuration_.name;
+
+    std::array<char, 256> buffer{};
+    bool announced = false;
+    const auto deadline = std::chrono::steady_clock::now() + udp_announcement_listen_time;
+    for (auto now = std::chrono::steady_clock::now(); !announced && now < deadline; now = std::chrono::steady_clock::now()) {
+      if (WaitForSocketReadable(discovery_socket_, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now)) <= 0) continue;
+
+      sockaddr_in from{};
+      socklen_t from_length = sizeof from;
+      const auto received =
+          recvfrom(discovery_socket_, buffer.data(), static_cast<int>(buffer.size()), 0, reinterpret_cast<sockaddr*>(&from), &from_length);
+
+      if (received <= 0 || std::string_view(buffer.data(), static_cast<size_t>(received)) != announcement) continue;
+
+      std::array<char, INET_ADDRSTRLEN> address{};
+      inet_ntop(AF_INET, &from.sin_addr, address.data(), address.size());
+
+      service_configuration.address = address.data();
+      service_configuration.port = ntohs(from.sin_port);
+      announced = true;
+    }
+
+    if (!announced) return false;
+  }
+
+  auto service = std::make_unique<UdpCommunicationService>(service_configuration);
+  if (!service->IsConnected()) return false;
+
+  logger.Log(kLoggerLevel_Info, "Found udp device %s", service->GetIdentifier().c_str());
+
+  out_devices.push_back(std::move(service));
+  found_device_ = true;
+
+  // the port is left for the other hand's prober
+  if (discovery_socket_ != invalid_socket_handle) {
+    CloseSocket(discovery_socket_);
+    discovery_socket_ = invalid_socket_handle;
+  }
+
+  return true;
+}
+
+UdpAnnouncementProber::~UdpAnnouncementProber() {
+  if (discovery_socket_ != invalid_socket_handle) CloseSocket(discovery_socket_);
+}
@@ -0,0 +1,34 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "communication/probers/prober.h"
+#include "communication/services/socket_util.h"
+#include "opengloves_interface.h"
+
+// listens for a device on the network announcing itself by name (see service_udp.h), or connects straight to it if its address is configured
+class UdpAnnouncementProber : public ICommunicationProber {
+ public:
+  explicit UdpAnnouncementProber(og::DeviceUdpCommunicationConfiguration configuration);
+
+  bool InquireDevices(std::vector<std::unique_ptr<ICommunicationService>>& out_devices) override;
+
+  ~UdpAnnouncementProber() override;
+
+ private:
+  bool OpenDiscoverySocket();
+
+  og::DeviceUdpCommunicationConfiguration configuration_;
+
+  SocketHandle discovery_socket_ = invalid_socket_handle;
+
+  // a device has no connection to be in use by, so is only given out once. The service then reconnects to it by itself
+  bool found_device_ = false;
+};
@@ -6,8 +6,12 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 
 enum CommunicationServiceEventType {
   kCommunicationEvent_UnexpectedDisconnect,
@@ -17,20 +21,38 @@ struct CommunicationServiceEvent {
   CommunicationServiceEventType type;
 };
 
+struct CommunicationServiceStatistics {
+  uint64_t read_syscalls;  // calls into the os to read from the device, including those that only wait for data
+  uint64_t write_syscalls;
+
+  uint64_t dropped_packets;  // received, but discarded as late or duplicate (ie. datagrams). Always 0 for a stream
+};
+
 /*
 Interface for a communication service (ie. bluetooth, serial)
 It is expected for a service to connect on construction
 */
 class ICommunicationService {
  public:
-  virtual bool ReceiveNextPacket(std::string& buff) = 0;
-  virtual bool RawWrite(const std::string& buff) = 0;
+  // Reads whatever is available (blocking until at least some data is) without any framing, which is left to the encoding.
+  // A read gives up after the service's read deadline, returning true with out_bytes_read as 0, so that a silent device can be noticed.
+  virtual bool ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) = 0;
+  virtual bool RawWrite(std::string_view buff) = 0;
+
+  // the most a single RawWrite should carry, so that a write is not held up behind (or split by) the transport's own buffering
+  virtual size_t GetWriteBudget() = 0;
 
   virtual bool IsConnected() = 0;
 
+  // closes the connection (if it is still open) and opens it again to the same device. Returns false if the device could not be reached
+  virtual bool Reconnect() = 0;
+
   virtual bool PrepareDisconnect() = 0;
 
   virtual std::string GetIdentifier() = 0;
 
+  // safe to call from any thread
+  virtual CommunicationServiceStatistics GetStatistics() = 0;
+
   virtual ~ICommunicationService() = default;
 };
\ No newline at end of file
@@ -4,10 +4,7 @@
 //
 // Initial Author: danwillm
 
+// bluetooth is only supported on windows
 #ifdef _WIN32
 #include "service_bluetooth_win.h"
-#else
-#ifdef linux
-#include "service_bluetooth_linux.h"
-#endif
 #endif
\ No newline at end of file
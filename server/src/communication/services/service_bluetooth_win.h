@@ -9,40 +9,23 @@
 #include <WinSock2.h>
 #include <bluetoothapis.h>
 
-#include <atomic>
-#include <mutex>
 #include <string>
 
-#include "communication/services/communication_service.h"
+#include "communication/services/service_stream_socket.h"
 
 #include "opengloves_interface.h"
 
-class BluetoothCommunicationService : public ICommunicationService {
+class BluetoothCommunicationService : public StreamSocketCommunicationService {
  public:
   explicit BluetoothCommunicationService(og::DeviceBluetoothCommunicationConfiguration configuration);
 
-  bool ReceiveNextPacket(std::string& buff) override;
-  bool RawWrite(const std::string& buff) override;
-
-  bool IsConnected() override;
-
-  bool PrepareDisconnect() override;
-
   std::string GetIdentifier() override;
 
   ~BluetoothCommunicationService() override;
 
- private:
-  bool Connect();
-
-  void LogError(const std::string&, bool with_win_error) const;
+ protected:
+  bool OpenSocket(SocketHandle& out_socket) override;
 
+ private:
   og::DeviceBluetoothCommunicationConfiguration configuration_;
-
-  SOCKET sock_{};
-
-  std::mutex io_mutex_;
-
-  std::atomic<bool> is_connected_ = false;
-  std::atomic<bool> is_disconnecting_ = false;
 };
\ No newline at end of file
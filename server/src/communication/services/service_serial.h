@@ -9,7 +9,7 @@
 #ifdef _WIN32
 #include "service_serial_win.h"
 #else
-#ifdef linux
+#ifdef __linux__
 #include "service_serial_linux.h"
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,340 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "service_serial_linux.h"
+
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include "opengloves_interface.h"
+
+using namespace og;
+
+static Logger& logger = Logger::GetInstance();
+
+// the tty layer buffers 4KB, so a write this size never has to wait for room behind another
+static constexpr size_t serial_write_budget = 256;
+
+// how long a read waits for the device to send anything before giving up
+static constexpr int serial_read_deadline_ms = 250;
+
+// how long a write waits for room in the driver's output queue before failing, the same as on windows
+static constexpr int serial_write_timeout_ms = 50;
+
+// the port is not connected yet, so only the descriptor needs closing
+#define ERROR_DISCONNECT_AND_RETURN(str_message) \
+  {                                              \
+    LogError(str_message);                       \
+    close(fd_);                                  \
+    fd_ = -1;                                    \
+    return false;                                \
+  }
+
+static bool GetBaudRateSpeed(const unsigned int baud_rate, speed_t& out_speed) {
+  switch (baud_rate) {
+    case 9600:
+      out_speed = B9600;
+      return true;
+    case 19200:
+      out_speed = B19200;
+      return true;
+    case 38400:
+      out_speed = B38400;
+      return true;
+    case 57600:
+      out_speed = B57600;
+      return true;
+    case 115200:
+      out_speed = B115200;
+      return true;
+    case 230400:
+      out_speed = B230400;
+      return true;
+    case 460800:
+      out_speed = B460800;
+      return true;
+    case 500000:
+      out_speed = B500000;
+      return true;
+    case 921600:
+      out_speed = B921600;
+      return true;
+    case 1000000:
+      out_speed = B1000000;
+      return true;
+    case 1500000:
+      out_speed = B1500000;
+      return true;
+    case 2000000:
+      out_speed = B2000000;
+      return true;
+    case 3000000:
+      out_speed = B3000000;
+      return true;
+    case 4000000:
+      out_speed = B4000000;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void SerialCommunicationService::LogError(const std::string& message, const bool with_errno) {
+  logger.Log(kLoggerLevel_Error, "%s, %s: %s", configuration_.port_name.c_str(), message.c_str(), with_errno ? std::strerror(errno) : "");
+}
+
+SerialCommunicationService::SerialCommunicationService(og::DeviceSerialCommunicationConfiguration configuration)
+    : configuration_(std::move(configuration)) {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    LogError("Failed to create serial port event descriptors");
+    return;
+  }
+
+  epoll_event wake_event{.events = EPOLLIN, .data = {.fd = wake_fd_}};
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake_event) != 0) {
+    LogError("Failed to watch serial port wake event");
+    return;
+  }
+
+  Connect();
+}
+
+bool SerialCommunicationService::IsConnected() {
+  return is_connected_;
+}
+
+bool SerialCommunicationService::Connect() {
+  is_connected_ = false;
+
+  fd_ = open(configuration_.port_name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+  // the port not existing (yet) is expected while probing, so isn't logged
+  if (fd_ < 0) return false;
+
+  // only one service may have the port open, as on windows. The probers keep trying ports a device was already found on, so that it being in
+  // use is expected and isn't logged either
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+    if (errno == EWOULDBLOCK) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+
+    ERROR_DISCONNECT_AND_RETURN("Failed to lock serial port");
+  }
+
+  speed_t speed;
+  if (!GetBaudRateSpeed(configuration_.baud_rate, speed)) ERROR_DISCONNECT_AND_RETURN("Unsupported baud rate");
+
+  termios tty{};
+  if (tcgetattr(fd_, &tty) != 0) ERROR_DISCONNECT_AND_RETURN("Failed to get current port parameters");
+
+  // 8N1, no flow control, and no line discipline, echo or translation of any bytes
+  cfmakeraw(&tty);
+  tty.c_cflag |= CLOCAL | CREAD;
+  tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+  tty.c_iflag &= ~(IXON | IXOFF | IXANY);
+
+  // the port is non blocking and reads wait with epoll instead, which PrepareDisconnect can wake. Any VMIN or VTIME would only hold bytes back in
+  // the driver to batch them, which adds latency to every line rather than saving reads
+  tty.c_cc[VMIN] = 0;
+  tty.c_cc[VTIME] = 0;
+
+  cfsetispeed(&tty, speed);
+  cfsetospeed(&tty, speed);
+
+  if (tcsetattr(fd_, TCSANOW, &tty) != 0) ERROR_DISCONNECT_AND_RETURN("Failed to set serial parameters");
+
+  // usb serial adapters otherwise hold bytes back for up to 16ms to fill a packet. Not every driver (ie. a pseudo terminal) supports this
+  serial_struct serial{};
+  if (ioctl(fd_, TIOCGSERIAL, &serial) == 0) {
+    serial.flags |= ASYNC_LOW_LATENCY;
+    ioctl(fd_, TIOCSSERIAL, &serial);
+  }
+
+  // anything already queued was sent before we were listening
+  tcflush(fd_, TCIOFLUSH);
+
+  epoll_event port_event{.events = EPOLLIN, .data = {.fd = fd_}};
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &port_event) != 0) ERROR_DISCONNECT_AND_RETURN("Failed to watch serial port");
+
+  logger.Log(og::kLoggerLevel_Info, "Successfully connected to serial port: %s", configuration_.port_name.c_str());
+
+  is_connected_ = true;
+
+  return true;
+}
+
+bool SerialCommunicationService::ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) {
+  if (!is_connected_) {
+    LogError("Cannot receive data as not connected to device", false);
+    return false;
+  }
+
+  if (is_disconnecting_) return false;
+
+  return ReadAvailable(buff, out_bytes_read);
+}
+
+bool SerialCommunicationService::ReadAvailable(std::span<char> buff, size_t& out_bytes_read) {
+  out_bytes_read = 0;
+
+  std::array<epoll_event, 2> events{};
+  read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  const int ready = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), serial_read_deadline_ms);
+
+  if (ready < 0) {
+    if (errno == EINTR) return true;
+
+    LogError("Failed waiting for data from serial port");
+    return false;
+  }
+
+  for (int i = 0; i < ready; i++) {
+    if (events[i].data.fd == wake_fd_) return false;
+  }
+
+  if (ready == 0) return true;
+
+  // takes everything the driver has buffered in one read. A device that went away shows as ready, then fails the read
+  read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  const ssize_t bytes_read = read(fd_, buff.data(), buff.size());
+
+  if (bytes_read < 0) {
+    if (errno == EAGAIN || errno == EINTR) return true;
+
+    LogError("Failed to read from serial port");
+    return false;
+  }
+
+  if (bytes_read == 0) {
+    LogError("Serial port was closed", false);
+    return false;
+  }
+
+  out_bytes_read = static_cast<size_t>(bytes_read);
+
+  return true;
+}
+
+bool SerialCommunicationService::RawWrite(std::string_view buff) {
+  if (!is_connected_) {
+    LogError("Cannot write to device as it is not connected", false);
+
+    return false;
+  }
+
+  while (!buff.empty()) {
+    write_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    const ssize_t bytes_written = write(fd_, buff.data(), buff.length());
+
+    if (bytes_written < 0) {
+      if (errno == EINTR) continue;
+
+      if (errno == EAGAIN) {
+        // the output queue is full, so wait for the device to take some of it
+        pollfd writable{.fd = fd_, .events = POLLOUT, .revents = 0};
+        write_syscalls_.fetch_add(1, std::memory_order_relaxed);
+        if (poll(&writable, 1, serial_write_timeout_ms) > 0) continue;
+
+        LogError("Timed out writing to serial port", false);
+        return false;
+      }
+
+      LogError("Failed to write to serial port");
+      return false;
+    }
+
+    buff.remove_prefix(static_cast<size_t>(bytes_written));
+  }
+
+  return true;
+}
+
+size_t SerialCommunicationService::GetWriteBudget() {
+  return serial_write_budget;
+}
+
+bool SerialCommunicationService::Reconnect() {
+  if (is_connected_) Disconnect();
+
+  return Connect();
+}
+
+bool SerialCommunicationService::PrepareDisconnect() {
+  is_disconnecting_ = true;
+
+  // wakes a read waiting in epoll
+  const uint64_t wake = 1;
+  if (write(wake_fd_, &wake, sizeof wake) != sizeof wake) {
+    LogError("Failed to wake serial port reads");
+
+    return false;
+  }
+
+  return true;
+}
+
+bool SerialCommunicationService::Disconnect() {
+  if (!is_connected_) {
+    LogError("Cannot disconnect from device is not connected", false);
+    return false;
+  }
+
+  is_connected_ = false;
+
+  // also takes it out of the epoll set
+  if (close(fd_) != 0) {
+    LogError("Failed to close serial port");
+    fd_ = -1;
+
+    return false;
+  }
+
+  fd_ = -1;
+
+  logger.Log(og::kLoggerLevel_Info, "Successfully disconnected from serial port");
+  return true;
+}
+
+SerialCommunicationService::~SerialCommunicationService() {
+  is_disconnecting_ = true;
+
+  if (is_connected_) {
+    Disconnect();
+
+    logger.Log(og::kLoggerLevel_Info, "Closing serial port communication service");
+  }
+
+  if (wake_fd_ >= 0) close(wake_fd_);
+  if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+std::string SerialCommunicationService::GetIdentifier() {
+  return configuration_.port_name;
+}
+
+CommunicationServiceStatistics SerialCommunicationService::GetStatistics() {
+  return {
+      .read_syscalls = read_syscalls_.load(std::memory_order_relaxed),
+      .write_syscalls = write_syscalls_.load(std::memory_order_relaxed),
+      .dropped_packets = 0,
+  };
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "communication/services/communication_service.h"
+#include "opengloves_interface.h"
+
+/**
+ * A serial port (ie. /dev/ttyUSB0) through termios, in raw mode. The port is non blocking and reads wait for data with epoll, alongside an
+ * eventfd that PrepareDisconnect signals so that a waiting read can be stopped. Anything that behaves as a tty works, including the slave end of a
+ * pseudo terminal, which lets the rest of the server be run against a simulated device.
+ */
+class SerialCommunicationService : public ICommunicationService {
+ public:
+  explicit SerialCommunicationService(og::DeviceSerialCommunicationConfiguration configuration);
+
+  bool ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) override;
+  bool RawWrite(std::string_view buff) override;
+  size_t GetWriteBudget() override;
+
+  bool IsConnected() override;
+  bool Reconnect() override;
+
+  bool PrepareDisconnect() override;
+
+  std::string GetIdentifier() override;
+
+  CommunicationServiceStatistics GetStatistics() override;
+
+  ~SerialCommunicationService() override;
+
+ private:
+  bool ReadAvailable(std::span<char> buff, size_t& out_bytes_read);
+
+  bool Connect();
+  bool Disconnect();
+
+  void LogError(const std::string& message, bool with_errno = true);
+
+  og::DeviceSerialCommunicationConfiguration configuration_;
+
+  int fd_ = -1;
+
+  // live as long as the service, so that they outlast reconnects
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+
+  std::atomic<bool> is_connected_ = false;
+  std::atomic<bool> is_disconnecting_ = false;
+
+  std::atomic<uint64_t> read_syscalls_ = 0;
+  std::atomic<uint64_t> write_syscalls_ = 0;
+};
@@ -12,10 +12,26 @@ using namespace og;
 
 static Logger& logger = Logger::GetInstance();
 
+// size of the driver's queues for the port. The input queue holds a few hundred samples, so a burst (or the communication thread being held up)
+// doesn't overrun it, and every read can take what has built up in one go
+static constexpr DWORD serial_input_queue_length = 16384;
+static constexpr DWORD serial_output_queue_length = 1024;
+
+// each write fits into the output queue with room to spare
+static constexpr size_t serial_write_budget = 256;
+
+// how long a read waits for the device to send anything before giving up
+static constexpr DWORD serial_read_deadline_ms = 250;
+
+// how long a write waits for room in the driver's output queue. A write that can't all be queued in this is a failed write
+static constexpr DWORD serial_write_timeout_ms = 50;
+
+// the port is not connected yet, so only the handle needs closing
 #define ERROR_DISCONNECT_AND_RETURN(str_message) \
   {                                              \
     LogError(str_message);                       \
-    Disconnect();                                \
+    CloseHandle(handle_);                        \
+    handle_ = INVALID_HANDLE_VALUE;              \
     return false;                                \
   }
 
@@ -47,6 +63,14 @@ void SerialCommunicationService::LogError(const std::string& message, bool with_
 
 SerialCommunicationService::SerialCommunicationService(og::DeviceSerialCommunicationConfiguration configuration)
     : configuration_(std::move(configuration)) {
+  // manual reset, as overlapped io needs
+  read_overlapped_.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  write_overlapped_.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  if (read_overlapped_.hEvent == nullptr || write_overlapped_.hEvent == nullptr) {
+    LogError("Failed to create serial port events");
+    return;
+  }
+
   Connect();
 }
 
@@ -57,7 +81,14 @@ bool SerialCommunicationService::IsConnected() {
 bool SerialCommunicationService::Connect() {
   is_connected_ = false;
 
-  handle_ = CreateFile(configuration_.port_name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  handle_ = CreateFile(
+      configuration_.port_name.c_str(),
+      GENERIC_READ | GENERIC_WRITE,
+      0,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+      nullptr);
 
   if (handle_ == INVALID_HANDLE_VALUE) return false;
 
@@ -65,23 +96,26 @@ bool SerialCommunicationService::Connect() {
 
   if (!GetCommState(handle_, &serial_params)) ERROR_DISCONNECT_AND_RETURN("Failed to get current port parameters");
 
-  serial_params.BaudRate = 115200;
+  serial_params.BaudRate = configuration_.baud_rate;
   serial_params.ByteSize = 8;
   serial_params.StopBits = ONESTOPBIT;
   serial_params.fParity = NOPARITY;
   serial_params.fDtrControl = DTR_CONTROL_ENABLE;
+  // otherwise a framing error or overrun stops all reads and writes until it is cleared
+  serial_params.fAbortOnError = FALSE;
 
   if (!SetCommState(handle_, &serial_params)) ERROR_DISCONNECT_AND_RETURN("Failed to set serial parameters");
 
+  // reads return straight away with whatever is queued, or wait up to the deadline for the first byte if nothing is
   COMMTIMEOUTS timeout;
-  timeout.ReadIntervalTimeout = 50;
-  timeout.ReadTotalTimeoutConstant = 0;
-  timeout.ReadTotalTimeoutMultiplier = 0;
-  timeout.WriteTotalTimeoutConstant = 50;
+  timeout.ReadIntervalTimeout = MAXDWORD;
+  timeout.ReadTotalTimeoutConstant = serial_read_deadline_ms;
+  timeout.ReadTotalTimeoutMultiplier = MAXDWORD;
+  timeout.WriteTotalTimeoutConstant = serial_write_timeout_ms;
   timeout.WriteTotalTimeoutMultiplier = 0;
   if (!SetCommTimeouts(handle_, &timeout)) ERROR_DISCONNECT_AND_RETURN("Failed to set port timeouts");
 
-  if (!SetupComm(handle_, 200, 200)) ERROR_DISCONNECT_AND_RETURN("Failed to set port buffer size");
+  if (!SetupComm(handle_, serial_input_queue_length, serial_output_queue_length)) ERROR_DISCONNECT_AND_RETURN("Failed to set port buffer size");
 
   logger.Log(og::kLoggerLevel_Info, "Successfully connected to COM port: %s", configuration_.port_name.c_str());
 
@@ -90,62 +124,87 @@ bool SerialCommunicationService::Connect() {
   return true;
 }
 
-bool SerialCommunicationService::ReceiveNextPacket(std::string& buff) {
+bool SerialCommunicationService::ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) {
   if (!is_connected_) {
-    LogError("Cannot receive packet as not connected to device", false);
+    LogError("Cannot receive data as not connected to device", false);
     return false;
   }
 
-  if (!SetCommMask(handle_, EV_RXCHAR)) {
-    LogError("Error setting comm mask");
-    return false;
-  }
+  if (is_disconnecting_) return false;
 
-  DWORD dwCommEvent = 0;
-  do {
-    if (!WaitCommEvent(handle_, &dwCommEvent, nullptr)) {
-      LogError("Error waiting for event");
-      return false;
-    }
-  } while (is_connected_ && (dwCommEvent & EV_RXCHAR) != EV_RXCHAR);
+  return ReadAvailable(buff, out_bytes_read);
+}
 
-  char next_char = 0;
+bool SerialCommunicationService::ReadAvailable(std::span<char> buff, size_t& out_bytes_read) {
+  out_bytes_read = 0;
+
+  // takes everything the driver has buffered in one read (see the port timeouts), only waiting if there is nothing queued
   DWORD bytes_read = 0;
-  do {
-    if (!ReadFile(handle_, &next_char, 1, &bytes_read, nullptr)) {
+  read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  if (!ReadFile(handle_, buff.data(), static_cast<DWORD>(buff.size()), nullptr, &read_overlapped_)) {
+    if (GetLastError() != ERROR_IO_PENDING) {
       LogError("Failed to read from serial port");
-
       return false;
     }
 
-    if (bytes_read <= 0 || next_char == '\n') continue;
+    // the port's timeouts finish the read at the deadline, this only makes sure of it
+    read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    if (WaitForSingleObject(read_overlapped_.hEvent, serial_read_deadline_ms) == WAIT_TIMEOUT) CancelIoEx(handle_, &read_overlapped_);
+  }
 
-    buff += next_char;
+  // whatever arrived before the deadline (or the io being cancelled to disconnect) is kept
+  if (!GetOverlappedResult(handle_, &read_overlapped_, &bytes_read, TRUE) && GetLastError() != ERROR_OPERATION_ABORTED) {
+    LogError("Failed to read from serial port");
+    return false;
+  }
 
-  } while (next_char != '\n' && !is_disconnecting_ && is_connected_);
+  out_bytes_read = bytes_read;
 
   return true;
 }
 
-bool SerialCommunicationService::RawWrite(const std::string& buff) {
+bool SerialCommunicationService::RawWrite(std::string_view buff) {
   if (!is_connected_) {
     LogError("Cannot write to device as it is not connected", false);
 
     return false;
   }
 
-  const char* cbuff = buff.c_str();
-  DWORD bytes_sent;
+  write_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  if (!WriteFile(handle_, buff.data(), static_cast<DWORD>(buff.length()), nullptr, &write_overlapped_) && GetLastError() != ERROR_IO_PENDING) {
+    LogError("Failed to write to serial port");
+
+    return false;
+  }
 
-  if (!WriteFile(handle_, cbuff, strlen(cbuff), &bytes_sent, nullptr)) {
+  // the port's write timeout bounds the wait
+  DWORD bytes_sent = 0;
+  if (!GetOverlappedResult(handle_, &write_overlapped_, &bytes_sent, TRUE)) {
     LogError("Failed to write to serial port");
 
     return false;
   }
 
+  // the rest couldn't be queued before the write timed out, so the device isn't taking what it is sent
+  if (bytes_sent != buff.length()) {
+    LogError("Timed out writing to serial port, " + std::to_string(bytes_sent) + " of " + std::to_string(buff.length()) + " bytes written", false);
+
+    return false;
+  }
+
   return true;
 }
 
+size_t SerialCommunicationService::GetWriteBudget() {
+  return serial_write_budget;
+}
+
+bool SerialCommunicationService::Reconnect() {
+  if (is_connected_) Disconnect();
+
+  return Connect();
+}
+
 bool SerialCommunicationService::PrepareDisconnect() {
   CancelIO();
   return true;
@@ -185,16 +244,27 @@ bool SerialCommunicationService::Disconnect() {
 }
 
 SerialCommunicationService::~SerialCommunicationService() {
-  if (!is_connected_) return;
+  if (is_connected_) {
+    is_disconnecting_ = true;
 
-  is_disconnecting_ = true;
+    CancelIO();
+    Disconnect();
 
-  CancelIO();
-  Disconnect();
+    logger.Log(og::kLoggerLevel_Info, "Closing serial port communication service");
+  }
 
-  logger.Log(og::kLoggerLevel_Info, "Closing serial port communication service");
+  if (read_overlapped_.hEvent != nullptr) CloseHandle(read_overlapped_.hEvent);
+  if (write_overlapped_.hEvent != nullptr) CloseHandle(write_overlapped_.hEvent);
 }
 
 std::string SerialCommunicationService::GetIdentifier() {
   return configuration_.port_name;
+}
+
+CommunicationServiceStatistics SerialCommunicationService::GetStatistics() {
+  return {
+      .read_syscalls = read_syscalls_.load(std::memory_order_relaxed),
+      .write_syscalls = write_syscalls_.load(std::memory_order_relaxed),
+      .dropped_packets = 0,
+  };
 }
\ No newline at end of file
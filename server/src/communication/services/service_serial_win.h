@@ -18,20 +18,26 @@ class SerialCommunicationService : public ICommunicationService {
  public:
   explicit SerialCommunicationService(og::DeviceSerialCommunicationConfiguration configuration);
 
-  bool ReceiveNextPacket(std::string& buff) override;
-  bool RawWrite(const std::string& buff) override;
+  bool ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) override;
+  bool RawWrite(std::string_view buff) override;
+  size_t GetWriteBudget() override;
 
   bool IsConnected() override;
+  bool Reconnect() override;
 
   bool PrepareDisconnect() override;
 
   std::string GetIdentifier() override;
 
+  CommunicationServiceStatistics GetStatistics() override;
+
   ~SerialCommunicationService();
 
  private:
   bool CancelIO();
 
+  bool ReadAvailable(std::span<char> buff, size_t& out_bytes_read);
+
   bool Connect();
   bool Disconnect();
 
@@ -41,6 +47,14 @@ class SerialCommunicationService : public ICommunicationService {
 
   HANDLE handle_;
 
+  // the port is opened for overlapped io, so that a write from the writer thread doesn't queue behind a read waiting on the communication thread.
+  // Each has its own, as they run at the same time
+  OVERLAPPED read_overlapped_{};
+  OVERLAPPED write_overlapped_{};
+
   std::atomic<bool> is_connected_ = false;
   std::atomic<bool> is_disconnecting_ = false;
+
+  std::atomic<uint64_t> read_syscalls_ = 0;
+  std::atomic<uint64_t> write_syscalls_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,140 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "service_stream_socket.h"
+
+#include "opengloves_interface.h"
+
+using namespace og;
+
+static Logger& logger = Logger::GetInstance();
+
+// a write that takes longer than this has stalled, and the link is reconnected
+static constexpr auto stream_socket_write_timeout = std::chrono::milliseconds(1000);
+
+StreamSocketCommunicationService::StreamSocketCommunicationService(const size_t write_budget, const std::chrono::milliseconds read_deadline)
+    : write_budget_(write_budget), read_deadline_(read_deadline) {}
+
+void StreamSocketCommunicationService::LogError(const std::string& message, const bool with_socket_error) {
+  logger.Log(
+      kLoggerLevel_Error, "%s, %s: %s", GetIdentifier().c_str(), message.c_str(), with_socket_error ? GetLastSocketErrorAsString().c_str() : "");
+}
+
+bool StreamSocketCommunicationService::Connect() {
+  if (!OpenSocket(socket_)) return false;
+
+  SetSocketSendTimeout(socket_, stream_socket_write_timeout);
+
+  is_connected_ = true;
+
+  return true;
+}
+
+void StreamSocketCommunicationService::Disconnect() {
+  if (!is_connected_.exchange(false)) return;
+
+  CloseSocket(socket_);
+}
+
+bool StreamSocketCommunicationService::IsConnected() {
+  return is_connected_;
+}
+
+bool StreamSocketCommunicationService::Reconnect() {
+  Disconnect();
+
+  return Connect();
+}
+
+bool StreamSocketCommunicationService::ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) {
+  if (!is_connected_ || is_disconnecting_) return false;
+
+  return Receive(buff, out_bytes_read);
+}
+
+bool StreamSocketCommunicationService::Receive(std::span<char> buff, size_t& out_bytes_read) {
+  out_bytes_read = 0;
+
+  read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  const int ready = WaitForSocketReadable(socket_, read_deadline_);
+
+  if (ready < 0) {
+    if (IsSocketInterrupted()) return true;
+
+    LogError("Received socket error waiting for data");
+    return false;
+  }
+
+  if (ready == 0) return true;
+
+  read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  const auto bytes_read = recv(socket_, buff.data(), static_cast<int>(buff.size()), 0);
+
+  if (bytes_read < 0) {
+    if (IsSocketInterrupted()) return true;
+
+    LogError("Received socket error reading from device");
+    return false;
+  }
+
+  if (bytes_read == 0) {
+    // the read side was shut down by PrepareDisconnect
+    if (!is_disconnecting_) LogError("Device closed the connection", false);
+
+    return false;
+  }
+
+  out_bytes_read = static_cast<size_t>(bytes_read);
+
+  return true;
+}
+
+bool StreamSocketCommunicationService::RawWrite(std::string_view buff) {
+  if (!is_connected_) return false;
+
+  // a stream socket may take only part of a write, the rest is sent after it
+  while (!buff.empty()) {
+    write_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    const auto bytes_sent = send(socket_, buff.data(), static_cast<int>(buff.length()), socket_send_flags);
+
+    if (bytes_sent < 0) {
+      if (IsSocketInterrupted()) continue;
+
+      LogError("Failed to send data to device");
+      return false;
+    }
+
+    buff.remove_prefix(static_cast<size_t>(bytes_sent));
+  }
+
+  return true;
+}
+
+size_t StreamSocketCommunicationService::GetWriteBudget() {
+  return write_budget_;
+}
+
+bool StreamSocketCommunicationService::PrepareDisconnect() {
+  is_disconnecting_ = true;
+
+  if (is_connected_) ShutdownSocketRead(socket_);
+
+  return true;
+}
+
+CommunicationServiceStatistics StreamSocketCommunicationService::GetStatistics() {
+  return {
+      .read_syscalls = read_syscalls_.load(std::memory_order_relaxed),
+      .write_syscalls = write_syscalls_.load(std::memory_order_relaxed),
+      .dropped_packets = 0,
+  };
+}
+
+StreamSocketCommunicationService::~StreamSocketCommunicationService() {
+  is_disconnecting_ = true;
+
+  Disconnect();
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "communication/services/communication_service.h"
+#include "communication/services/socket_util.h"
+
+/**
+ * A transport over a connected stream socket, ie. bluetooth rfcomm, or a tcp or socketpair stand in for a device in benchmarks.
+ * Reads are only made from the communication thread and writes from the writer thread, which a socket allows at the same time, so there is no
+ * lock between them and a write never waits on a read. Each read takes everything the socket has buffered that fits.
+ *
+ * Derived classes open the socket, and must call Connect from their constructor.
+ */
+class StreamSocketCommunicationService : public ICommunicationService {
+ public:
+  bool ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) override;
+  bool RawWrite(std::string_view buff) override;
+  size_t GetWriteBudget() override;
+
+  bool IsConnected() override;
+  bool Reconnect() override;
+
+  // wakes a read that is waiting for data, so that the thread making it can be stopped
+  bool PrepareDisconnect() override;
+
+  CommunicationServiceStatistics GetStatistics() override;
+
+  ~StreamSocketCommunicationService() override;
+
+ protected:
+  StreamSocketCommunicationService(size_t write_budget, std::chrono::milliseconds read_deadline);
+
+  // opens a socket that is connected to the device
+  virtual bool OpenSocket(SocketHandle& out_socket) = 0;
+
+  bool Connect();
+  void Disconnect();
+
+  void LogError(const std::string& message, bool with_socket_error = true);
+
+ private:
+  bool Receive(std::span<char> buff, size_t& out_bytes_read);
+
+  size_t write_budget_;
+  std::chrono::milliseconds read_deadline_;
+
+  SocketHandle socket_{};
+
+  std::atomic<bool> is_connected_ = false;
+  std::atomic<bool> is_disconnecting_ = false;
+
+  std::atomic<uint64_t> read_syscalls_ = 0;
+  std::atomic<uint64_t> write_syscalls_ = 0;
+};
@@ -0,0 +1,239 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "service_udp.h"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "opengloves_interface.h"
+
+using namespace og;
+
+static Logger& logger = Logger::GetInstance();
+
+// small enough to never be fragmented, and more than any sample or output needs
+static constexpr size_t udp_max_datagram_length = 512;
+
+// how long a read waits for the device to send anything before giving up
+static constexpr auto udp_read_deadline = std::chrono::milliseconds(250);
+
+// enough for a few hundred samples, so that the os doesn't drop any while the communication thread is held up
+static constexpr int udp_receive_buffer_size = 256 * 1024;
+
+UdpCommunicationService::UdpCommunicationService(og::DeviceUdpCommunicationConfiguration configuration)
+    : configuration_(std::move(configuration)) {
+  Connect();
+}
+
+void UdpCommunicationService::LogError(const std::string& message, const bool with_socket_error) {
+  logger.Log(
+      kLoggerLevel_Error, "%s, %s: %s", GetIdentifier().c_str(), message.c_str(), with_socket_error ? GetLastSocketErrorAsString().c_str() : "");
+}
+
+bool UdpCommunicationService::Connect() {
+  if (!InitialiseSockets()) {
+    LogError("Failed to start up sockets");
+    return false;
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(configuration_.port);
+  if (inet_pton(AF_INET, configuration_.address.c_str(), &address.sin_addr) != 1) {
+    LogError("Device address is not a valid ipv4 address", false);
+    return false;
+  }
+
+  socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (socket_ == invalid_socket_handle) {
+    LogError("Failed to create socket");
+    return false;
+  }
+
+  // only datagrams from the device are received, and sends go to it
+  if (connect(socket_, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0) {
+    LogError("Failed to connect to device");
+    CloseSocket(socket_);
+
+    return false;
+  }
+
+  // reads wait with select, then take every datagram that has arrived without blocking
+  if (!SetSocketNonBlocking(socket_)) {
+    LogError("Failed to make socket non blocking");
+    CloseSocket(socket_);
+
+    return false;
+  }
+
+  setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&udp_receive_buffer_size), sizeof udp_receive_buffer_size);
+
+  // the device may have restarted, so whatever sequence it sends next is taken as the start
+  has_received_ = false;
+  is_connected_ = true;
+
+  return true;
+}
+
+void UdpCommunicationService::Disconnect() {
+  if (!is_connected_.exchange(false)) return;
+
+  CloseSocket(socket_);
+  socket_ = invalid_socket_handle;
+}
+
+bool UdpCommunicationService::IsConnected() {
+  return is_connected_;
+}
+
+bool UdpCommunicationService::Reconnect() {
+  Disconnect();
+
+  return Connect();
+}
+
+bool UdpCommunicationService::ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) {
+  if (!is_connected_ || is_disconnecting_) return false;
+
+  return Receive(buff, out_bytes_read);
+}
+
+bool UdpCommunicationService::Receive(std::span<char> buff, size_t& out_bytes_read) {
+  out_bytes_read = 0;
+
+  read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  const int ready = WaitForSocketReadable(socket_, udp_read_deadline);
+
+  if (ready < 0) {
+    if (IsSocketInterrupted()) return true;
+
+    LogError("Received socket error waiting for data");
+    return false;
+  }
+
+  if (ready == 0) return true;
+
+  // every datagram that has arrived is taken while there is room for another, so a burst costs one wait
+  std::array<char, udp_max_datagram_length> datagram{};
+  do {
+    read_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    const auto received = recv(socket_, datagram.data(), static_cast<int>(datagram.size()), 0);
+
+    if (received < 0) {
+      // the device wasn't listening when we last wrote to it, ie. it is restarting. That is up to the read deadline to notice
+      if (IsSocketWouldBlock() || IsSocketInterrupted() || IsSocketConnectionRefused()) break;
+
+      LogError("Received socket error reading from device");
+      return false;
+    }
+
+    size_t payload_length;
+    if (!AcceptDatagram(std::span(datagram.data(), static_cast<size_t>(received)), payload_length)) continue;
+
+    if (payload_length > buff.size() - out_bytes_read) {
+      dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    std::memcpy(buff.data() + out_bytes_read, datagram.data() + udp_header_length, payload_length);
+    out_bytes_read += payload_length;
+  } while (buff.size() - out_bytes_read >= udp_max_datagram_length - udp_header_length);
+
+  return true;
+}
+
+bool UdpCommunicationService::AcceptDatagram(const std::span<char> datagram, size_t& out_payload_length) {
+  if (datagram.size() < udp_header_length) {
+    dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t sequence = 0;
+  for (size_t i = 0; i < udp_header_length; i++) sequence |= static_cast<uint32_t>(static_cast<uint8_t>(datagram[i])) << (i * 8);
+
+  // a newer sample has already been taken, so this one is of no use. Anything too far behind is the device counting from the start again
+  const uint32_t behind = last_received_sequence_ - sequence;
+  if (has_received_ && behind < udp_reorder_window) {
+    dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  has_received_ = true;
+  last_received_sequence_ = sequence;
+
+  out_payload_length = datagram.size() - udp_header_length;
+
+  return true;
+}
+
+bool UdpCommunicationService::RawWrite(std::string_view buff) {
+  if (!is_connected_) return false;
+
+  std::array<char, udp_max_datagram_length> datagram{};
+  while (!buff.empty()) {
+    const size_t payload_length = std::min(buff.length(), datagram.size() - udp_header_length);
+
+    const uint32_t sequence = next_sent_sequence_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < udp_header_length; i++) datagram[i] = static_cast<char>(sequence >> (i * 8));
+    std::memcpy(datagram.data() + udp_header_length, buff.data(), payload_length);
+
+    write_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    const auto sent = send(socket_, datagram.data(), static_cast<int>(udp_header_length + payload_length), socket_send_flags);
+
+    if (sent < 0) {
+      if (IsSocketInterrupted()) continue;
+
+      // as with a datagram lost on the way, the next output replaces this one. A device that isn't listening is left to the read deadline
+      if (!IsSocketWouldBlock() && !IsSocketConnectionRefused()) {
+        LogError("Failed to send data to device");
+        return false;
+      }
+    }
+
+    buff.remove_prefix(payload_length);
+  }
+
+  return true;
+}
+
+size_t UdpCommunicationService::GetWriteBudget() {
+  return udp_max_datagram_length - udp_header_length;
+}
+
+bool UdpCommunicationService::PrepareDisconnect() {
+  is_disconnecting_ = true;
+
+  if (is_connected_) ShutdownSocketRead(socket_);
+
+  return true;
+}
+
+std::string UdpCommunicationService::GetIdentifier() {
+  return configuration_.name + " (" + configuration_.address + ":" + std::to_string(configuration_.port) + ")";
+}
+
+CommunicationServiceStatistics UdpCommunicationService::GetStatistics() {
+  return {
+      .read_syscalls = read_syscalls_.load(std::memory_order_relaxed),
+      .write_syscalls = write_syscalls_.load(std::memory_order_relaxed),
+      .dropped_packets = dropped_packets_.load(std::memory_order_relaxed),
+  };
+}
+
+UdpCommunicationService::~UdpCommunicationService() {
+  is_disconnecting_ = true;
+
+  Disconnect();
+}
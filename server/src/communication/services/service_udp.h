@@ -0,0 +1,83 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "communication/services/communication_service.h"
+#include "communication/services/socket_util.h"
+#include "opengloves_interface.h"
+
+/**
+ * A device on the network (ie. an esp32 over wifi), over udp. Every datagram, in either direction, is:
+ *
+ *   [sequence: u32 little endian][payload]
+ *
+ * The sequence counts up by one for each datagram the sender sends. A datagram with a sequence at or before the last one received (that is not
+ * more than udp_reorder_window behind, which is taken as the sender having restarted) is late or a duplicate, and is dropped. The device sends
+ * one sample per datagram, with the payload encoded as it would be on any other transport (an alpha packet or a binary frame).
+ *
+ * The device sends its samples to wherever the last datagram it received came from, so it starts streaming once the handshake reaches it.
+ *
+ * A device that is not streaming to anyone announces itself by broadcasting udp_announcement_prefix followed by its name to udp_discovery_port,
+ * from the port it listens on.
+ */
+static constexpr uint16_t udp_discovery_port = 52070;
+static constexpr const char* udp_announcement_prefix = "opengloves:";
+
+static constexpr size_t udp_header_length = sizeof(uint32_t);
+static constexpr uint32_t udp_reorder_window = 1024;
+
+class UdpCommunicationService : public ICommunicationService {
+ public:
+  // address and port must be set
+  explicit UdpCommunicationService(og::DeviceUdpCommunicationConfiguration configuration);
+
+  bool ReceiveNextChunk(std::span<char> buff, size_t& out_bytes_read) override;
+  bool RawWrite(std::string_view buff) override;
+  size_t GetWriteBudget() override;
+
+  bool IsConnected() override;
+  bool Reconnect() override;
+
+  bool PrepareDisconnect() override;
+
+  std::string GetIdentifier() override;
+
+  CommunicationServiceStatistics GetStatistics() override;
+
+  ~UdpCommunicationService() override;
+
+ private:
+  // reads every datagram that has arrived that fits into buff, waiting up to the read deadline for the first
+  bool Receive(std::span<char> buff, size_t& out_bytes_read);
+
+  // strips the header from the datagram at the start of buff. Returns false if it should be dropped
+  bool AcceptDatagram(std::span<char> datagram, size_t& out_payload_length);
+
+  bool Connect();
+  void Disconnect();
+
+  void LogError(const std::string& message, bool with_socket_error = true);
+
+  og::DeviceUdpCommunicationConfiguration configuration_;
+
+  SocketHandle socket_ = invalid_socket_handle;
+
+  bool has_received_ = false;
+  uint32_t last_received_sequence_ = 0;
+  std::atomic<uint32_t> next_sent_sequence_ = 0;
+
+  std::atomic<bool> is_connected_ = false;
+  std::atomic<bool> is_disconnecting_ = false;
+
+  std::atomic<uint64_t> read_syscalls_ = 0;
+  std::atomic<uint64_t> write_syscalls_ = 0;
+  std::atomic<uint64_t> dropped_packets_ = 0;
+};
@@ -0,0 +1,134 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "socket_util.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef _WIN32
+bool InitialiseSockets() {
+  WSAData data{};
+
+  return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+
+std::string GetLastSocketErrorAsString() {
+  const DWORD error_id = ::WSAGetLastError();
+  if (error_id == 0) return "";
+
+  LPSTR message_buffer = nullptr;
+  const size_t size = FormatMessageA(
+      FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+      nullptr,
+      error_id,
+      MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+      reinterpret_cast<LPSTR>(&message_buffer),
+      0,
+      nullptr);
+
+  std::string message(message_buffer, size);
+
+  LocalFree(message_buffer);
+
+  return message;
+}
+
+bool IsSocketInterrupted() {
+  return false;
+}
+
+bool IsSocketWouldBlock() {
+  return ::WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+bool IsSocketConnectionRefused() {
+  return ::WSAGetLastError() == WSAECONNRESET;
+}
+
+bool SetSocketNonBlocking(const SocketHandle socket) {
+  u_long non_blocking = 1;
+
+  return ioctlsocket(socket, FIONBIO, &non_blocking) == 0;
+}
+
+void SetSocketSendTimeout(const SocketHandle socket, const std::chrono::milliseconds timeout) {
+  const DWORD timeout_ms = static_cast<DWORD>(timeout.count());
+  setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof timeout_ms);
+}
+
+void ShutdownSocketRead(const SocketHandle socket) {
+  shutdown(socket, SD_RECEIVE);
+}
+
+void CloseSocket(const SocketHandle socket) {
+  shutdown(socket, SD_BOTH);
+  closesocket(socket);
+}
+#else
+bool InitialiseSockets() {
+  return true;
+}
+
+std::string GetLastSocketErrorAsString() {
+  return std::strerror(errno);
+}
+
+bool IsSocketInterrupted() {
+  return errno == EINTR;
+}
+
+bool IsSocketWouldBlock() {
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+bool IsSocketConnectionRefused() {
+  return errno == ECONNREFUSED;
+}
+
+bool SetSocketNonBlocking(const SocketHandle socket) {
+  const int flags = fcntl(socket, F_GETFL);
+
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void SetSocketSendTimeout(const SocketHandle socket, const std::chrono::milliseconds timeout) {
+  const timeval timeout_tv{.tv_sec = static_cast<time_t>(timeout.count() / 1000), .tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+  setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout_tv, sizeof timeout_tv);
+}
+
+void ShutdownSocketRead(const SocketHandle socket) {
+  shutdown(socket, SHUT_RD);
+}
+
+void CloseSocket(const SocketHandle socket) {
+  shutdown(socket, SHUT_RDWR);
+  close(socket);
+}
+#endif
+
+int WaitForSocketReadable(const SocketHandle socket, const std::chrono::milliseconds deadline) {
+  // a socket that timed out a recv can't be used again on windows, so deadlines are kept by select rather than SO_RCVTIMEO
+  fd_set read_set;
+  FD_ZERO(&read_set);
+  FD_SET(socket, &read_set);
+
+  timeval deadline_tv{
+      .tv_sec = static_cast<decltype(timeval::tv_sec)>(deadline.count() / 1000),
+      .tv_usec = static_cast<decltype(timeval::tv_usec)>(deadline.count() % 1000 * 1000)};
+
+  const int ready = select(static_cast<int>(socket) + 1, &read_set, nullptr, nullptr, &deadline_tv);
+
+  return ready < 0 ? -1 : ready;
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#include <chrono>
+#include <string>
+
+// the differences between winsock and posix sockets, for the transports built on them
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+static constexpr SocketHandle invalid_socket_handle = INVALID_SOCKET;
+
+static constexpr int socket_send_flags = 0;
+#else
+using SocketHandle = int;
+static constexpr SocketHandle invalid_socket_handle = -1;
+
+// a device that went away is reported by send failing, rather than by SIGPIPE ending the process
+static constexpr int socket_send_flags = MSG_NOSIGNAL;
+#endif
+
+// starts up winsock, safe to call more than once. Nothing needs doing elsewhere
+bool InitialiseSockets();
+
+// the error from the last socket call on this thread
+std::string GetLastSocketErrorAsString();
+
+// the last socket call was interrupted by a signal before it did anything, and can be made again
+bool IsSocketInterrupted();
+
+// the last socket call on a non blocking socket would have had to wait
+bool IsSocketWouldBlock();
+
+// the other end of a datagram socket wasn't listening when something was last sent to it (reported by a later call)
+bool IsSocketConnectionRefused();
+
+bool SetSocketNonBlocking(SocketHandle socket);
+void SetSocketSendTimeout(SocketHandle socket, std::chrono::milliseconds timeout);
+
+// returns 1 once the socket has something to read, 0 if the deadline passed first or -1 on error
+int WaitForSocketReadable(SocketHandle socket, std::chrono::milliseconds deadline);
+
+// wakes anything waiting to read from the socket
+void ShutdownSocketRead(SocketHandle socket);
+
+void CloseSocket(SocketHandle socket);
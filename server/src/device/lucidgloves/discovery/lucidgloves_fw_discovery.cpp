@@ -7,18 +7,23 @@
 #include "lucidgloves_fw_discovery.h"
 
 #include <chrono>
+#include <limits>
 #include <utility>
 
-#include "communication/encoding/alpha_encoding_service.h"
+#include "communication/encoding/encoding_service.h"
 #include "communication/managers/hardware_communication_manager.h"
-#include "communication/probers/prober_bluetooth_connectable.h"
 #include "communication/probers/prober_serial_connectable.h"
-#include "communication/probers/prober_serial_identifiers_win.h"
-#include "communication/services/service_bluetooth.h"
+#include "communication/probers/prober_serial_identifiers.h"
+#include "communication/probers/prober_udp_announcement.h"
 #include "communication/services/service_serial.h"
 #include "device/lucidgloves/lucidgloves_device.h"
 #include "opengloves_interface.h"
 
+// bluetooth is only supported on windows
+#ifdef _WIN32
+#include "communication/probers/prober_bluetooth_connectable.h"
+#endif
+
 static og::Logger& logger = og::Logger::GetInstance();
 
 static const std::vector<SerialProberIdentifier> lucidgloves_serial_ids = {
@@ -27,6 +32,12 @@ static const std::vector<SerialProberIdentifier> lucidgloves_serial_ids = {
 };
 static const std::vector<std::string> lucidgloves_bt_ids = {"lucidgloves", "lucidgloves-left", "lucidgloves-right"};
 
+// how often probers look for devices when they can't be told that one may have been plugged in
+static constexpr auto prober_poll_interval = std::chrono::milliseconds(2000);
+
+// how often hotplugged probers look anyway, for what isn't seen as a change (ie. another program letting go of a port)
+static constexpr auto prober_hotplug_poll_interval = std::chrono::seconds(30);
+
 LucidglovesDeviceDiscoverer::LucidglovesDeviceDiscoverer(
     og::CommunicationConfiguration communication_configuration, std::vector<og::DeviceConfiguration> device_configurations)
     : device_configurations_(std::move(device_configurations)), communication_configuration_(communication_configuration) {}
@@ -40,7 +51,15 @@ void LucidglovesDeviceDiscoverer::StartDiscovery(std::function<void(std::unique_
     return;
   }
 
+  std::vector<std::string> serial_ports;
+  for (const auto& device_configuration : device_configurations_) serial_ports.push_back(device_configuration.communication.serial.port_name);
+  hotplug_watcher_ = std::make_unique<HotplugWatcher>(serial_ports);
+
+  // before any prober thread starts, as they stop once it is false
+  is_active_ = true;
+
   if (communication_configuration_.bluetooth.enabled) {
+#ifdef _WIN32
     logger.Log(og::kLoggerLevel_Info, "Setting up bluetooth probers...");
 
     for (const auto& device_configuration : device_configurations_) {
@@ -51,9 +70,13 @@ void LucidglovesDeviceDiscoverer::StartDiscovery(std::function<void(std::unique_
           &LucidglovesDeviceDiscoverer::ProberThread,
           this,
           std::make_unique<BluetoothPortProber>(prober_configuration),
+          false,
           [=](std::unique_ptr<ICommunicationService> service) { OnDeviceFound(device_configuration, std::move(service)); }
           );
     }
+#else
+    logger.Log(og::kLoggerLevel_Warning, "Not probing for bluetooth devices as bluetooth is not supported on this platform");
+#endif
   } else {
     logger.Log(og::kLoggerLevel_Info, "Not probing for bluetooth devices as it was disabled in settings");
   }
@@ -64,22 +87,43 @@ void LucidglovesDeviceDiscoverer::StartDiscovery(std::function<void(std::unique_
     for (const auto& device_configuration : device_configurations_) {
       const og::DeviceSerialCommunicationConfiguration& configuration = device_configuration.communication.serial;
 
-      SerialPortProberConfiguration prober_configuration{configuration.port_name};
+      SerialPortProberConfiguration prober_configuration{configuration.port_name, configuration.baud_rate};
       prober_threads_.emplace_back(std::thread(
           &LucidglovesDeviceDiscoverer::ProberThread,
           this,
           std::make_unique<SerialPortProber>(prober_configuration),
+          true,
           [=](std::unique_ptr<ICommunicationService> service) { OnDeviceFound(device_configuration, std::move(service)); }));
     }
   } else {
     logger.Log(og::kLoggerLevel_Info, "Not probing for serial devices as it was disabled in settings");
   }
 
-  is_active_ = true;
+  if (communication_configuration_.udp.enabled) {
+    logger.Log(og::kLoggerLevel_Info, "Setting up udp probers...");
+
+    for (const auto& device_configuration : device_configurations_) {
+      prober_threads_.emplace_back(
+          &LucidglovesDeviceDiscoverer::ProberThread,
+          this,
+          std::make_unique<UdpAnnouncementProber>(device_configuration.communication.udp),
+          false,
+          [=](std::unique_ptr<ICommunicationService> service) { OnDeviceFound(device_configuration, std::move(service)); });
+    }
+  } else {
+    logger.Log(og::kLoggerLevel_Info, "Not probing for udp devices as it was disabled in settings");
+  }
 }
 
 void LucidglovesDeviceDiscoverer::ProberThread(
-    std::unique_ptr<ICommunicationProber> prober, const std::function<void(std::unique_ptr<ICommunicationService> service)>& callback) {
+    std::unique_ptr<ICommunicationProber> prober,
+    const bool hotplugged,
+    const std::function<void(std::unique_ptr<ICommunicationService> service)>& callback) {
+  const bool wait_for_hotplug = hotplugged && hotplug_watcher_->IsWatching();
+
+  // changes only wake this thread if it is hotplugged, otherwise only the poll interval (or stopping) does
+  uint64_t seen_changes = wait_for_hotplug ? hotplug_watcher_->GetChanges() : std::numeric_limits<uint64_t>::max();
+
   while (is_active_) {
     std::vector<std::unique_ptr<ICommunicationService>> found_services;
 
@@ -89,32 +133,52 @@ void LucidglovesDeviceDiscoverer::ProberThread(
       callback(std::move(service));
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+    const uint64_t changes = hotplug_watcher_->WaitForChange(seen_changes, wait_for_hotplug ? prober_hotplug_poll_interval : prober_poll_interval);
+    if (wait_for_hotplug) seen_changes = changes;
   }
 }
 
 void LucidglovesDeviceDiscoverer::OnDeviceFound(const og::DeviceConfiguration& configuration, std::unique_ptr<ICommunicationService> service) {
-  std::lock_guard<std::mutex> lock(device_found_mutex_);
+  og::DeviceConfiguration device_configuration = configuration;
 
-  std::unique_ptr<IEncodingService> encoding_service = std::make_unique<AlphaEncodingService>(configuration.communication.encoding);
+  std::unique_ptr<IEncodingService> encoding_service =
+      CreateEncodingService(device_configuration.communication.encoding_type, device_configuration.communication.encoding);
 
   std::unique_ptr<ICommunicationManager> communication_manager;
-  switch (configuration.type) {
+  switch (device_configuration.type) {
     default:
       logger.Log(og::kLoggerLevel_Warning, "Unknown or unset device type. Using hardware communication manager.");
-    case og::kDeviceType_lucidgloves:
-      communication_manager = std::make_unique<HardwareCommunicationManager>(std::move(service), std::move(encoding_service));
+    case og::kDeviceType_lucidgloves: {
+      auto hardware_communication_manager = std::make_unique<HardwareCommunicationManager>(std::move(service), std::move(encoding_service));
+
+      // the device knows which hand it is, so what it says takes priority over the port it was configured on
+      og::InputInfoData info{};
+      if (hardware_communication_manager->Handshake(device_configuration.communication, info) && info.hand != device_configuration.hand) {
+        logger.Log(
+            og::kLoggerLevel_Info,
+            "Device reported that it is the %s hand, using that over the configured hand",
+            info.hand == og::kHandLeft ? "left" : "right");
+        device_configuration.hand = info.hand;
+      }
+
+      communication_manager = std::move(hardware_communication_manager);
       break;
+    }
   }
 
-  std::unique_ptr<og::IDevice> lucidgloves_device = std::make_unique<LucidglovesDevice>(configuration, std::move(communication_manager));
+  std::unique_ptr<og::IDevice> lucidgloves_device = std::make_unique<LucidglovesDevice>(device_configuration, std::move(communication_manager));
 
+  // the handshake is done outside of the lock so that a slow device doesn't hold up the other hand
+  std::lock_guard<std::mutex> lock(device_found_mutex_);
   callback_(std::move(lucidgloves_device));
 }
 
 void LucidglovesDeviceDiscoverer::StopDiscovery() {
   if (is_active_.exchange(false)) {
     logger.Log(og::kLoggerLevel_Info, "Attempting to clean up queryable device probers...");
+
+    // wakes the probers that are waiting to look again
+    hotplug_watcher_->Stop();
     for (auto& prober_thread : prober_threads_) {
       prober_thread.join();
     }
@@ -12,6 +12,7 @@
 #include <mutex>
 #include <vector>
 
+#include "communication/probers/hotplug_watcher.h"
 #include "communication/probers/prober.h"
 #include "communication/encoding/encoding_service.h"
 #include "communication/services/communication_service.h"
@@ -28,11 +29,16 @@ class LucidglovesDeviceDiscoverer : public og::IDeviceDiscoverer {
   ~LucidglovesDeviceDiscoverer() override;
 
  private:
-  void ProberThread(std::unique_ptr<ICommunicationProber> prober, const std::function<void(std::unique_ptr<ICommunicationService> service)>& callback);
+  // a prober that is hotplugged looks for devices when one may have been plugged in, the rest look every few seconds
+  void ProberThread(
+      std::unique_ptr<ICommunicationProber> prober,
+      bool hotplugged,
+      const std::function<void(std::unique_ptr<ICommunicationService> service)>& callback);
   void OnDeviceFound(const og::DeviceConfiguration& configuration, std::unique_ptr<ICommunicationService> service);
 
   std::function<void(std::unique_ptr<og::IDevice> device)> callback_;
 
+  std::unique_ptr<HotplugWatcher> hotplug_watcher_;
   std::vector<std::thread> prober_threads_;
 
   std::mutex device_found_mutex_;
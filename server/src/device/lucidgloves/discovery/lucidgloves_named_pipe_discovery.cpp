@@ -13,21 +13,23 @@ static og::Logger& logger = og::Logger::GetInstance();
 
 class LucidglovesNamedPipeDiscovery::Impl {
  public:
-  Impl(){};
+  explicit Impl(og::NamedPipeCommunicationConfiguration configuration) : configuration_(configuration){};
 
   void StartListeners(std::function<void(og::Hand hand, std::unique_ptr<ICommunicationManager>)> on_client_connected_callback) {
     on_client_connected_callback_ = std::move(on_client_connected_callback);
 
-    on_client_connected_callback_(og::kHandLeft, std::make_unique<NamedPipeCommunicationManager>(og::kHandLeft, [&]() {
+    on_client_connected_callback_(og::kHandLeft, std::make_unique<NamedPipeCommunicationManager>(og::kHandLeft, configuration_, [&]() {
                                     logger.Log(og::kLoggerLevel_Info, "Left hand named pipe client connected");
                                   }));
 
-    on_client_connected_callback_(og::kHandRight, std::make_unique<NamedPipeCommunicationManager>(og::kHandRight, [&]() {
+    on_client_connected_callback_(og::kHandRight, std::make_unique<NamedPipeCommunicationManager>(og::kHandRight, configuration_, [&]() {
                                     logger.Log(og::kLoggerLevel_Info, "Right hand named pipe client connected");
                                   }));
   }
 
  private:
+  og::NamedPipeCommunicationConfiguration configuration_;
+
   std::unique_ptr<NamedPipeCommunicationManager> left_named_pipe_manager_;
   std::unique_ptr<NamedPipeCommunicationManager> right_named_pipe_manager_;
 
@@ -35,8 +37,8 @@ class LucidglovesNamedPipeDiscovery::Impl {
   std::function<void(const og::InputData&)> on_data_callback_;
 };
 
-LucidglovesNamedPipeDiscovery::LucidglovesNamedPipeDiscovery() {
-  pImpl_ = std::make_unique<Impl>();
+LucidglovesNamedPipeDiscovery::LucidglovesNamedPipeDiscovery(og::NamedPipeCommunicationConfiguration configuration) {
+  pImpl_ = std::make_unique<Impl>(configuration);
 }
 
 void LucidglovesNamedPipeDiscovery::StartDiscovery(std::function<void(std::unique_ptr<og::IDevice>)> callback) {
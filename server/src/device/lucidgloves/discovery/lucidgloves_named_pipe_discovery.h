@@ -12,7 +12,7 @@
 
 class LucidglovesNamedPipeDiscovery : public og::IDeviceDiscoverer {
  public:
-  LucidglovesNamedPipeDiscovery();
+  explicit LucidglovesNamedPipeDiscovery(og::NamedPipeCommunicationConfiguration configuration);
 
   void StartDiscovery(std::function<void(std::unique_ptr<og::IDevice> device)> callback) override;
 
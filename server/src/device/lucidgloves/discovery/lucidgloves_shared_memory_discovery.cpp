@@ -0,0 +1,25 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "lucidgloves_shared_memory_discovery.h"
+
+#include "communication/managers/shared_memory_communication_manager.h"
+#include "device/lucidgloves/lucidgloves_device.h"
+
+static og::Logger& logger = og::Logger::GetInstance();
+
+void LucidglovesSharedMemoryDiscovery::StartDiscovery(std::function<void(std::unique_ptr<og::IDevice>)> callback) {
+  logger.Log(og::kLoggerLevel_Info, "Starting shared memory input listener...");
+
+  for (const og::Hand hand : {og::kHandLeft, og::kHandRight}) {
+    og::DeviceConfiguration configuration{};
+
+    configuration.hand = hand;
+    configuration.type = og::kDeviceType_lucidgloves;
+
+    callback(std::make_unique<LucidglovesDevice>(configuration, std::make_unique<SharedMemoryCommunicationManager>(hand)));
+  }
+}
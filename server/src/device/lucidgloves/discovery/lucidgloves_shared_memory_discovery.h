@@ -0,0 +1,19 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "opengloves_interface.h"
+
+// a device for each hand, fed by software input sources through shared memory. As with the named pipes, the devices exist whether or not a source is
+// publishing, and are reported connected once one is
+class LucidglovesSharedMemoryDiscovery : public og::IDeviceDiscoverer {
+ public:
+  void StartDiscovery(std::function<void(std::unique_ptr<og::IDevice> device)> callback) override;
+};
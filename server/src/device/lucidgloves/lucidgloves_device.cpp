@@ -6,9 +6,13 @@
 
 #include "lucidgloves_device.h"
 
+#include <atomic>
+#include <thread>
+
 #include "opengloves_interface.h"
 #include "services/input/input_force_feedback_named_pipe.h"
 #include "services/output/output_osc.h"
+#include "util/triple_buffer.h"
 
 using namespace og;
 
@@ -35,14 +39,23 @@ class LucidglovesDevice::Impl {
     });
   };
 
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+    communication_manager_->ListenForConnectionState(std::move(callback));
+  }
+
   void ListenForInput(std::function<void(const og::InputPeripheralData &)> callback) {
     callback_ = std::move(callback);
 
+    consumer_active_ = true;
+    consumer_thread_ = std::thread(&LucidglovesDevice::Impl::ConsumerThread, this);
+
+    // the communication thread only hands the sample over, so that a slow consumer never holds up reading from the device
     communication_manager_->BeginListener([&](const Input &data) {
       if (data.type == kInputDataType_Peripheral) {
-        callback_(data.data.peripheral);
+        if (samples_.Write(data.data.peripheral)) samples_overwritten_.fetch_add(1, std::memory_order_relaxed);
 
-        OutputOSCServer::GetInstance().Send(hand_, data.data.peripheral);
+        sample_signal_.fetch_add(1, std::memory_order_release);
+        sample_signal_.notify_one();
       }
     });
 
@@ -53,15 +66,63 @@ class LucidglovesDevice::Impl {
     communication_manager_->WriteOutput(output);
   }
 
+  og::DeviceStatistics GetStatistics() {
+    og::DeviceStatistics result = communication_manager_->GetStatistics();
+
+    result.input = {
+        .delivered = samples_delivered_.load(std::memory_order_relaxed),
+        .overwritten = samples_overwritten_.load(std::memory_order_relaxed),
+    };
+
+    return result;
+  }
+
   ~Impl() {
     force_feedback_ = nullptr;
     communication_manager_ = nullptr;
+
+    // the communication thread has stopped, so no more samples will be written
+    if (consumer_active_.exchange(false)) {
+      sample_signal_.fetch_add(1, std::memory_order_release);
+      sample_signal_.notify_one();
+      consumer_thread_.join();
+    }
   }
 
  private:
+  void ConsumerThread() {
+    og::InputPeripheralData sample;
+
+    while (consumer_active_) {
+      const uint32_t signal = sample_signal_.load(std::memory_order_acquire);
+
+      if (!samples_.TryRead(sample)) {
+        sample_signal_.wait(signal, std::memory_order_acquire);
+        continue;
+      }
+
+      samples_delivered_.fetch_add(1, std::memory_order_relaxed);
+
+      callback_(sample);
+
+      OutputOSCServer::GetInstance().Send(hand_, sample);
+    }
+  }
+
   og::Hand hand_;
 
   std::function<void(og::InputPeripheralData)> callback_;
+
+  std::atomic<bool> consumer_active_ = false;
+  std::thread consumer_thread_;
+
+  // the latest sample from the communication thread, for the consumer thread to pass to the callback and osc
+  TripleBuffer<og::InputPeripheralData> samples_;
+  // bumped after every sample is written, the consumer thread waits on it changing
+  std::atomic<uint32_t> sample_signal_ = 0;
+
+  std::atomic<uint64_t> samples_delivered_ = 0;
+  std::atomic<uint64_t> samples_overwritten_ = 0;
   std::unique_ptr<ICommunicationManager> communication_manager_;
   std::unique_ptr<InputForceFeedbackNamedPipe> force_feedback_;
 };
@@ -73,6 +134,10 @@ LucidglovesDevice::LucidglovesDevice(og::DeviceConfiguration configuration, std:
   OutputOSCServer::GetInstance();
 };
 
+void LucidglovesDevice::ListenForConnectionState(std::function<void(og::DeviceConnectionState)> callback) {
+  pImpl_->ListenForConnectionState(std::move(callback));
+}
+
 void LucidglovesDevice::ListenForInput(std::function<void(const og::InputPeripheralData &)> callback) {
   pImpl_->ListenForInput(callback);
 }
@@ -81,6 +146,10 @@ void LucidglovesDevice::Output(const og::Output &output) {
   pImpl_->Output(output);
 }
 
+og::DeviceStatistics LucidglovesDevice::GetStatistics() {
+  return pImpl_->GetStatistics();
+}
+
 og::DeviceConfiguration LucidglovesDevice::GetConfiguration() {
   return configuration_;
 }
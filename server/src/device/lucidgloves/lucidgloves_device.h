@@ -17,10 +17,13 @@ class LucidglovesDevice : public og::IDevice {
   LucidglovesDevice(og::DeviceConfiguration configuration, std::unique_ptr<ICommunicationManager> communication_manager);
 
   og::DeviceConfiguration GetConfiguration() override;
+  void ListenForConnectionState(std::function<void(og::DeviceConnectionState state)> callback) override;
   void ListenForInput(std::function<void(const og::InputPeripheralData& data)> callback) override;
 
   void Output(const og::Output& output) override;
 
+  og::DeviceStatistics GetStatistics() override;
+
   ~LucidglovesDevice() override;
 
  private:
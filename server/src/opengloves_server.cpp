@@ -8,6 +8,7 @@
 
 #include "device/lucidgloves/discovery/lucidgloves_fw_discovery.h"
 #include "device/lucidgloves/discovery/lucidgloves_named_pipe_discovery.h"
+#include "device/lucidgloves/discovery/lucidgloves_shared_memory_discovery.h"
 #include "opengloves_interface.h"
 
 using namespace og;
@@ -25,7 +26,10 @@ class Server::Impl {
 
     // lucidgloves firmware discovery (or other firmwares that use the same communication methods and encoding schemes)
     device_discoverers_.emplace_back(std::make_unique<LucidglovesDeviceDiscoverer>(configuration_.communication, configuration_.devices));
-    if (configuration_.communication.named_pipe.enabled) device_discoverers_.emplace_back(std::make_unique<LucidglovesNamedPipeDiscovery>());
+    if (configuration_.communication.named_pipe.enabled) {
+      device_discoverers_.emplace_back(std::make_unique<LucidglovesNamedPipeDiscovery>(configuration_.communication.named_pipe));
+    }
+    if (configuration_.communication.shared_memory.enabled) device_discoverers_.emplace_back(std::make_unique<LucidglovesSharedMemoryDiscovery>());
 
     for (auto& discoverer : device_discoverers_) {
       discoverer->StartDiscovery(callback);
@@ -6,22 +6,23 @@
 
 #include "input_force_feedback_named_pipe.h"
 
-#include "named_pipe/named_pipe_win.h"
+#include "ipc/ipc_listener.h"
 
 static og::Logger& logger = og::Logger::GetInstance();
 
 class InputForceFeedbackNamedPipe::Impl {
  public:
   Impl(og::Hand hand, std::function<void(const ForceFeedbackCurlData&)> on_data_callback) : on_data_callback_(std::move(on_data_callback)) {
-    const std::string pipe_name = R"(\\.\pipe\vrapplication\ffb\curl\)" + std::string(hand == og::kHandLeft ? "left" : "right");
+    // \\.\pipe\vrapplication\ffb\curl\<hand> on windows
+    const std::string pipe_name = "vrapplication/ffb/curl/" + std::string(hand == og::kHandLeft ? "left" : "right");
 
-    pipe_listener_ = std::make_unique<NamedPipeListener<ForceFeedbackCurlData>>(
+    pipe_listener_ = std::make_unique<IpcListener<ForceFeedbackCurlData>>(
         pipe_name,
-        [&](const NamedPipeListenerEvent& event) {
-          if (event.type == NamedPipeListenerEventType::ClientConnected)
+        [hand](const IpcListenerEvent& event) {
+          if (event.type == IpcListenerEventType::ClientConnected)
             logger.Log(og::kLoggerLevel_Info, "Force feedback pipe connected for %s hand", hand == og::kHandLeft ? "left" : "right");
         },
-        [&](const ForceFeedbackCurlData* data) { on_data_callback_(*data); });
+        [&](uint64_t, const ForceFeedbackCurlData* data) { on_data_callback_(*data); });
   }
 
   void StartListening() {
@@ -31,7 +32,7 @@ class InputForceFeedbackNamedPipe::Impl {
  private:
   std::function<void(const ForceFeedbackCurlData&)> on_data_callback_;
 
-  std::unique_ptr<INamedPipeListener> pipe_listener_;
+  std::unique_ptr<IIpcListener> pipe_listener_;
 };
 
 InputForceFeedbackNamedPipe::InputForceFeedbackNamedPipe(og::Hand hand, std::function<void(const ForceFeedbackCurlData&)> on_data_callback)
@@ -6,6 +6,7 @@
 
 #include "output_osc.h"
 
+#include <cstdio>
 #include <sstream>
 
 #define MINIOSC_IMPLEMENTATION
@@ -26,15 +27,15 @@ class OutputOSCServer::Impl {
 
     char address[100];
 
-    sprintf_s(address, "/avatar/parameters/%s%sSplay", hand_string, "Thumb");
+    std::snprintf(address, sizeof address, "/avatar/parameters/%s%sSplay", hand_string, "Thumb");
     minioscBundle(&bundle, address, ",f", input.splay[0]);
-    sprintf_s(address, "/avatar/parameters/%s%sSplay", hand_string, "Index");
+    std::snprintf(address, sizeof address, "/avatar/parameters/%s%sSplay", hand_string, "Index");
     minioscBundle(&bundle, address, ",f", input.splay[1]);
-    sprintf_s(address, "/avatar/parameters/%s%sSplay", hand_string, "Middle");
+    std::snprintf(address, sizeof address, "/avatar/parameters/%s%sSplay", hand_string, "Middle");
     minioscBundle(&bundle, address, ",f", input.splay[2]);
-    sprintf_s(address, "/avatar/parameters/%s%sSplay", hand_string, "Ring");
+    std::snprintf(address, sizeof address, "/avatar/parameters/%s%sSplay", hand_string, "Ring");
     minioscBundle(&bundle, address, ",f", input.splay[3]);
-    sprintf_s(address, "/avatar/parameters/%s%sSplay", hand_string, "Pinky");
+    std::snprintf(address, sizeof address, "/avatar/parameters/%s%sSplay", hand_string, "Pinky");
     minioscBundle(&bundle, address, ",f", input.splay[4]);
 
 
@@ -0,0 +1,16 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "byte_scanner.h"
+
+#include <cstring>
+
+size_t FindByte(const char* data, size_t length, char value) {
+  // the c library's memchr is already vectorised, and packets are too short for anything hand written to beat it
+  const void* result = std::memchr(data, value, length);
+
+  return result == nullptr ? length : static_cast<const char*>(result) - data;
+}
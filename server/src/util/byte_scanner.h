@@ -0,0 +1,44 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Scanning of byte blocks received from devices by the encodings (finding the end of a packet, and character classification).
+ */
+
+enum ByteClass : uint8_t {
+  kByteClass_None = 0,
+  kByteClass_Letter = 1 << 0,      // A-Z
+  kByteClass_OpenParen = 1 << 1,   // (
+  kByteClass_CloseParen = 1 << 2,  // )
+  kByteClass_Digit = 1 << 3,       // 0-9
+
+  kByteClass_Key = kByteClass_Letter | kByteClass_OpenParen | kByteClass_CloseParen,
+};
+
+static constexpr std::array<uint8_t, 256> BuildByteClassTable() {
+  std::array<uint8_t, 256> result{};
+  for (int value = 'A'; value <= 'Z'; value++) result[value] = kByteClass_Letter;
+  for (int value = '0'; value <= '9'; value++) result[value] = kByteClass_Digit;
+  result['('] = kByteClass_OpenParen;
+  result[')'] = kByteClass_CloseParen;
+
+  return result;
+}
+
+inline constexpr std::array<uint8_t, 256> byte_class_table = BuildByteClassTable();
+
+constexpr uint8_t ClassifyByte(const char value) {
+  return byte_class_table[static_cast<uint8_t>(value)];
+}
+
+// Returns the index of the first occurrence of value in data, or length if it does not occur.
+size_t FindByte(const char* data, size_t length, char value);
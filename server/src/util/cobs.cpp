@@ -0,0 +1,110 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "util/cobs.h"
+
+#include <algorithm>
+
+bool CobsEncode(std::span<const uint8_t> data, std::span<uint8_t> out, size_t& out_length) {
+  out_length = 0;
+  if (out.size() < CobsMaxEncodedLength(data.size())) return false;
+
+  size_t code_index = 0;
+  size_t length = 1;
+  uint8_t code = 1;
+
+  for (const uint8_t byte : data) {
+    if (byte != 0) {
+      out[length++] = byte;
+      code++;
+    }
+
+    // a zero, or a full block, ends the block by writing its length back to where it started
+    if (byte == 0 || code == 0xFF) {
+      out[code_index] = code;
+      code_index = length++;
+      code = 1;
+    }
+  }
+
+  out[code_index] = code;
+  out_length = length;
+
+  return true;
+}
+
+CobsStreamDecoder::CobsStreamDecoder(std::span<uint8_t> buffer) : buffer_(buffer) {}
+
+size_t CobsStreamDecoder::Decode(std::span<const uint8_t> data, FrameStatus& out_status) {
+  out_status = kFrameStatus_Incomplete;
+
+  size_t i = 0;
+  while (i < data.size()) {
+    // copy the rest of the current block in one go. Valid data has no zeros inside a block, so a zero ends the run (and the frame)
+    if (block_remaining_ != 0 && !malformed_) {
+      const size_t available = std::min<size_t>(block_remaining_, data.size() - i);
+      const size_t run = std::find(data.begin() + i, data.begin() + i + available, 0) - (data.begin() + i);
+
+      if (run > buffer_.size() - length_) {
+        malformed_ = true;
+        continue;
+      }
+
+      std::copy_n(data.begin() + i, run, buffer_.begin() + length_);
+      length_ += run;
+      block_remaining_ -= run;
+      i += run;
+
+      if (run == available) continue;
+    }
+
+    const uint8_t byte = data[i++];
+
+    if (byte == 0) {
+      if (!started_)
+        out_status = kFrameStatus_Empty;
+      else if (malformed_ || block_remaining_ != 0)
+        out_status = kFrameStatus_Malformed;
+      else
+        out_status = kFrameStatus_Ok;
+
+      frame_length_ = length_;
+      Reset();
+
+      return i;
+    }
+
+    started_ = true;
+    if (malformed_) continue;
+
+    // a new block. The zero that ended the previous block is only written now, as the last block of a frame doesn't end in one
+    if (block_ends_in_zero_) {
+      if (length_ == buffer_.size()) {
+        malformed_ = true;
+        continue;
+      }
+
+      buffer_[length_++] = 0;
+    }
+
+    block_remaining_ = byte - 1;
+    block_ends_in_zero_ = byte != 0xFF;
+  }
+
+  return data.size();
+}
+
+std::span<const uint8_t> CobsStreamDecoder::GetFrame() const {
+  return buffer_.first(frame_length_);
+}
+
+void CobsStreamDecoder::Reset() {
+  length_ = 0;
+  block_remaining_ = 0;
+  block_ends_in_zero_ = false;
+  started_ = false;
+  malformed_ = false;
+}
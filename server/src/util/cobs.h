@@ -0,0 +1,56 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * Consistent Overhead Byte Stuffing. Encoded data never contains a zero byte, so zeros can delimit frames on a byte stream and a receiver that
+ * joins part way through (or loses bytes) resynchronises at the next zero. The overhead is one byte per 254 bytes of data, plus one.
+ */
+
+constexpr size_t CobsMaxEncodedLength(const size_t length) {
+  return length + length / 254 + 1;
+}
+
+// encodes data into out, without a delimiter. Returns false (with out_length 0) if it did not fit
+bool CobsEncode(std::span<const uint8_t> data, std::span<uint8_t> out, size_t& out_length);
+
+// Decodes frames from a stream one byte range at a time, so a frame can be split between reads at any byte.
+class CobsStreamDecoder {
+ public:
+  enum FrameStatus {
+    kFrameStatus_Incomplete,  // the data ended before the delimiter
+    kFrameStatus_Ok,          // a frame was decoded into the buffer
+    kFrameStatus_Empty,       // two delimiters in a row, there was no frame
+    kFrameStatus_Malformed,   // the frame was not valid cobs, or did not fit into the buffer
+  };
+
+  // decoded frames are written to buffer, which must outlive the decoder
+  explicit CobsStreamDecoder(std::span<uint8_t> buffer);
+
+  // decodes up to and including the first delimiter. Returns the number of bytes used
+  size_t Decode(std::span<const uint8_t> data, FrameStatus& out_status);
+
+  // the frame decoded by the last call that returned kFrameStatus_Ok
+  [[nodiscard]] std::span<const uint8_t> GetFrame() const;
+
+  // drops any partial frame
+  void Reset();
+
+ private:
+  std::span<uint8_t> buffer_;
+  size_t length_ = 0;
+  size_t frame_length_ = 0;
+
+  uint8_t block_remaining_ = 0;  // bytes left in the current block, 0 when the next byte is a block code
+  bool block_ends_in_zero_ = false;
+  bool started_ = false;
+  bool malformed_ = false;
+};
@@ -0,0 +1,50 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#include "util/crc16.h"
+
+#include <array>
+
+static constexpr uint16_t crc16_polynomial = 0x1021;
+
+// Slice by 4: table[k][x] is the crc of byte x followed by k zero bytes. Four bytes are then folded in with independent lookups, rather than a
+// chain of four dependent ones, which is what limits the byte at a time version.
+using Crc16Tables = std::array<std::array<uint16_t, 256>, 4>;
+
+static constexpr Crc16Tables BuildCrc16Tables() {
+  Crc16Tables result{};
+  for (int i = 0; i < 256; i++) {
+    uint16_t crc = static_cast<uint16_t>(i << 8);
+    for (int bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ crc16_polynomial) : static_cast<uint16_t>(crc << 1);
+
+    result[0][i] = crc;
+  }
+
+  for (size_t k = 1; k < result.size(); k++) {
+    for (int i = 0; i < 256; i++) {
+      const uint16_t previous = result[k - 1][i];
+      result[k][i] = static_cast<uint16_t>((previous << 8) ^ result[0][previous >> 8]);
+    }
+  }
+
+  return result;
+}
+
+static constexpr Crc16Tables crc16_tables = BuildCrc16Tables();
+
+uint16_t Crc16(std::span<const uint8_t> data) {
+  uint16_t crc = 0xFFFF;
+
+  size_t i = 0;
+  for (; i + 4 <= data.size(); i += 4) {
+    const auto high = static_cast<uint16_t>(crc ^ ((data[i] << 8) | data[i + 1]));
+    crc = crc16_tables[3][high >> 8] ^ crc16_tables[2][high & 0xFF] ^ crc16_tables[1][data[i + 2]] ^ crc16_tables[0][data[i + 3]];
+  }
+
+  for (; i < data.size(); i++) crc = static_cast<uint16_t>((crc << 8) ^ crc16_tables[0][(crc >> 8) ^ data[i]]);
+
+  return crc;
+}
@@ -0,0 +1,13 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), as implemented by most microcontroller crc libraries
+uint16_t Crc16(std::span<const uint8_t> data);
@@ -0,0 +1,72 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded lock free queue for many producers and a single consumer. Each slot has a sequence number that says whether it is free to push to or
+ * ready to pop from, so producers only contend on claiming a position and never wait on the consumer (or each other) while copying a value in.
+ * Capacity must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class MpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  MpscQueue() {
+    for (size_t i = 0; i < Capacity; i++) slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // safe to call from any thread. Returns false if the queue was full
+  bool TryPush(const T& value) {
+    size_t position = push_position_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[position & (Capacity - 1)];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+      if (sequence == position) {
+        if (push_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < position) {
+        // the slot still holds a value from the last lap that has not been popped
+        return false;
+      } else {
+        position = push_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // only to be called from the consumer thread. Returns false if the queue was empty, or the next value is still being pushed
+  bool TryPop(T& out_value) {
+    Slot& slot = slots_[pop_position_ & (Capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != pop_position_ + 1) return false;
+
+    out_value = slot.value;
+    slot.sequence.store(pop_position_ + Capacity, std::memory_order_release);
+    pop_position_++;
+
+    return true;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::array<Slot, Capacity> slots_;
+
+  // kept on separate cache lines, as producers and the consumer write them from different threads
+  alignas(64) std::atomic<size_t> push_position_ = 0;
+  alignas(64) size_t pop_position_ = 0;
+};
@@ -0,0 +1,55 @@
+// Copyright (c) 2023 LucidVR
+//
+// SPDX-License-Identifier: MIT
+//
+// Initial Author: danwillm
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock free handoff of the latest value from a single producer to a single consumer. There are three slots: the producer fills its own, then
+ * swaps it with the middle one, which the consumer swaps with its own to read. Neither side waits on the other, and a value the consumer was too
+ * slow to take is replaced by the next one rather than queued behind it.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  // only to be called from the producer thread. Returns true if the last value written was never read, so has been overwritten
+  bool Write(const T& value) {
+    slots_[back_].value = value;
+
+    const uint8_t previous = middle_.exchange(back_ | new_value_flag, std::memory_order_acq_rel);
+    back_ = previous & index_mask;
+
+    return (previous & new_value_flag) != 0;
+  }
+
+  // only to be called from the consumer thread. Returns false if nothing has been written since the last read
+  bool TryRead(T& out_value) {
+    if ((middle_.load(std::memory_order_relaxed) & new_value_flag) == 0) return false;
+
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+    out_value = slots_[front_].value;
+
+    return true;
+  }
+
+ private:
+  static constexpr uint8_t index_mask = 0b011;
+  static constexpr uint8_t new_value_flag = 0b100;
+
+  // kept on separate cache lines, as the producer and consumer copy in and out of them from different threads
+  struct alignas(64) Slot {
+    T value;
+  };
+  std::array<Slot, 3> slots_{};
+
+  // index of the middle slot, with new_value_flag set if it was written after the consumer last took it
+  alignas(64) std::atomic<uint8_t> middle_ = 1;
+  alignas(64) uint8_t back_ = 0;
+  alignas(64) uint8_t front_ = 2;
+};